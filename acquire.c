@@ -0,0 +1,92 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Double-Buffered Acquisition, see acquire.h                                      */
+/*                                                                                 */
+/***********************************************************************************/
+#include "acquire.h"
+#include <string.h> // for memset().
+
+/***********************************************************************************/
+/* function to set up empty blocks */
+/* period is the nominal spacing of the readings in ticks of the time stamps. */
+void acquireInit(struct acquire *a, unsigned short period)
+{
+  memset(a, 0, sizeof(*a));
+  a->period = period;
+  statsInit(&a->spacing);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to start over the timing statistics, after a summary */
+void acquireClear(struct acquire *a)
+{
+  memset(a->jitter, 0, sizeof(a->jitter));
+  statsInit(&a->spacing);
+  a->overruns = 0;
+  a->missed = 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to count a spacing in the jitter histogram */
+static void addJitter(struct acquire *a, unsigned short spacing)
+{
+  unsigned short d = spacing > a->period ? spacing - a->period : a->period - spacing;
+  unsigned long edge = ACQUIRE_JITTER_STEP;
+  int b;
+
+  for (b=0;b<ACQUIRE_JITTER_BINS-1 && d >= edge;b++)
+    edge <<= 1;
+  a->jitter[b]++;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to store one reading taken at time stamp */
+/* returns 1 when it completed a block for the processing end, 0 otherwise. */
+/* the spacing wraps with the 16-bit stamps, so readings must be less than */
+/* 65536 ticks apart (2 s at the 32768 Hz rtimer of the Sky). */
+int acquireAdd(struct acquire *a, float light_lx, float temp_c, unsigned short stamp)
+{
+  if (a->started)
+  {
+    statsAdd(&a->spacing, (unsigned short)(stamp - a->last));
+    addJitter(a, (unsigned short)(stamp - a->last));
+  }
+  a->last = stamp;
+  a->started = 1;
+
+  a->light[a->fill][a->count] = light_lx;
+  a->temp[a->fill][a->count] = temp_c;
+  if (++a->count < ACQUIRE_BLOCK)
+    return 0;
+
+  a->count = 0;
+  if (a->full)
+  {
+    a->overruns++; // refilled in place, the processing end is behind.
+    return 0;
+  }
+  a->full = 1;
+  a->fill ^= 1;
+  return 1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the block held by the processing end */
+/* returns 0 or 1, or -1 when no block is complete. */
+int acquireBlock(const struct acquire *a)
+{
+  return a->full ? a->fill ^ 1 : -1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to give the processed block back to the sampling end */
+void acquireRelease(struct acquire *a)
+{
+  a->full = 0;
+}
+/***********************************************************************************/
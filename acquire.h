@@ -0,0 +1,73 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Double-Buffered Acquisition                                                     */
+/*                                                                                 */
+/* Decouples the sampling of the sensors from their processing. The sampling end   */
+/* writes each reading into one of two blocks of ACQUIRE_BLOCK readings; when the  */
+/* block is full it is handed to the processing end and sampling goes on in the    */
+/* other block, so a slow processing step (a regression, a report) delays the      */
+/* output of the readings, not the instants they are taken at.                     */
+/*                                                                                 */
+/* Every reading carries a time stamp from a free-running 16-bit tick counter      */
+/* (RTIMER_NOW() on the mote). The spacing between readings is kept as summary     */
+/* statistics (sensor-proc.h) and as a histogram of its deviation from the         */
+/* sampling period, over logarithmic bins: bin 0 holds deviations under            */
+/* ACQUIRE_JITTER_STEP ticks, bin b > 0 those under ACQUIRE_JITTER_STEP << b, the  */
+/* last bin all larger ones. A block completed while the processing end still      */
+/* holds the other one is dropped and counted as an overrun; sampling instants the */
+/* sampling end could not keep are counted as missed.                              */
+/*                                                                                 */
+/* Plain C without Contiki: sensor.c samples in one process and processes in       */
+/* another (PROJECT_SOURCEFILES += acquire.c).                                     */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef ACQUIRE_H_
+#define ACQUIRE_H_
+
+#include "sensor-proc.h"
+
+#ifdef SENSOR_CONF_ACQUIRE_BLOCK
+#define ACQUIRE_BLOCK SENSOR_CONF_ACQUIRE_BLOCK // readings per block handed to processing.
+#else
+#define ACQUIRE_BLOCK 2 // processing has 1 s per block, readings come out 1 s late at most.
+#endif
+
+#ifdef SENSOR_CONF_ACQUIRE_REPORT
+#define ACQUIRE_REPORT SENSOR_CONF_ACQUIRE_REPORT // readings between sampling summaries.
+#else
+#define ACQUIRE_REPORT 120 // one a minute.
+#endif
+
+#ifdef SENSOR_CONF_ACQUIRE_JITTER_STEP
+#define ACQUIRE_JITTER_STEP SENSOR_CONF_ACQUIRE_JITTER_STEP // ticks, width of jitter bin 0.
+#else
+#define ACQUIRE_JITTER_STEP 16 // 0.49 ms at the 32768 Hz rtimer of the Sky.
+#endif
+
+#define ACQUIRE_JITTER_BINS 10 // the last starts at 125 ms with the default step.
+
+STATIC_ASSERT(ACQUIRE_BLOCK >= 1 && ACQUIRE_BLOCK <= 255, block_fits_count);
+
+struct acquire
+{
+  float light[2][ACQUIRE_BLOCK];  // lx.
+  float temp[2][ACQUIRE_BLOCK];   // C.
+  unsigned char fill;             // block being filled, 0 or 1.
+  unsigned char count;            // readings in it.
+  unsigned char full;             // the other block is held by the processing end.
+  unsigned char started;          // a reading was taken, last is valid.
+  unsigned short last;            // time stamp of the last reading.
+  unsigned short period;          // ticks between readings, nominal.
+  struct stats spacing;           // ticks between readings.
+  unsigned long jitter[ACQUIRE_JITTER_BINS]; // readings by deviation of the spacing.
+  unsigned long overruns;         // blocks dropped.
+  unsigned long missed;           // sampling instants skipped.
+};
+
+void acquireInit(struct acquire *a, unsigned short period);
+void acquireClear(struct acquire *a);
+int acquireAdd(struct acquire *a, float light_lx, float temp_c, unsigned short stamp);
+int acquireBlock(const struct acquire *a);
+void acquireRelease(struct acquire *a);
+
+#endif /* ACQUIRE_H_ */
@@ -0,0 +1,110 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Rollup Relay                                                                    */
+/*                                                                                 */
+/* Intermediate node of the collection tree of rollup.h. Merges the summaries its  */
+/* children send during one reporting period (REPORT_FREQ readings of the motes)   */
+/* and sends the merged summary to its parent ROLLUP_PARENT0.ROLLUP_PARENT1 at the */
+/* end of the period. Run on the sink (SINK_ADDR0.SINK_ADDR1), it prints the       */
+/* summary of the whole tree instead:                                              */
+/*                                                                                 */
+/*   Rollup: 16 motes, 96 readings, mean 917.402 lx, std 1.538 lx,                 */
+/*   min 913.238 lx, max 922.394 lx, median 917.104 lx, p90 919.941 lx             */
+/*                                                                                 */
+/* The motes' clocks are not synchronized, so a period may merge zero or two       */
+/* summaries of one child; no reading is counted twice or lost, they only move to  */
+/* the neighbouring period. Build with PROJECT_SOURCEFILES += sensor-proc.c        */
+/* report-codec.c transport.c rollup.c.                                            */
+/*                                                                                 */
+/***********************************************************************************/
+#include "contiki.h"
+#include "net/rime/rime.h"
+#include "sensor-proc.h"
+#include "rollup.h"
+#include <stdio.h> // for printf().
+
+STATIC_ASSERT(ROLLUP_MAX_BYTES <= PACKETBUF_SIZE, summary_fits_packetbuf);
+
+static struct unicast_conn uc;
+static struct rollup period; // summaries of the children in this period.
+
+/***********************************************************************************/
+/* function to print the summary of the whole tree */
+static void printRollup(const struct rollup *r)
+{
+  const struct stats *s = &r->stats;
+  float std = statsStdDev(s);
+  float median = rollupQuantile(r, 0.5);
+  float p90 = rollupQuantile(r, 0.9);
+
+  printf("Rollup: %lu motes, %lu readings, ", r->motes, s->count);
+  printf("mean %d.%03u lx, std %d.%03u lx,\n", d1(s->mean), d2(s->mean), d1(std), d2(std));
+  printf("min %d.%03u lx, max %d.%03u lx, ", d1(s->min), d2(s->min), d1(s->max), d2(s->max));
+  printf("median %d.%03u lx, p90 %d.%03u lx\n", d1(median), d2(median), d1(p90), d2(p90));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function called by Rime for every summary received */
+static void recvSummary(struct unicast_conn *c, const linkaddr_t *from)
+{
+  static struct rollup r; // static, too big for the stack of the Rime process.
+
+  if (rollupUnpack(&r, packetbuf_dataptr(), packetbuf_datalen()) < 0)
+  {
+    printf("Summary from %u.%u dropped\n", from->u8[0], from->u8[1]);
+    return;
+  }
+  rollupMerge(&period, &r);
+}
+
+static const struct unicast_callbacks unicast_callbacks = {recvSummary};
+/***********************************************************************************/
+
+/*---------------------------------------------------------------------------*/
+PROCESS(relay_process, "Rollup relay process");
+AUTOSTART_PROCESSES(&relay_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(relay_process, ev, data)
+{
+  static struct etimer timer;
+  static unsigned char buf[ROLLUP_MAX_BYTES]; // packed summary.
+  static int len;
+  static int is_sink;
+  linkaddr_t parent;
+
+  PROCESS_EXITHANDLER(unicast_close(&uc);)
+
+  PROCESS_BEGIN();
+  rollupInit(&period);
+  unicast_open(&uc, ROLLUP_CHANNEL, &unicast_callbacks);
+  is_sink = linkaddr_node_addr.u8[0] == SINK_ADDR0 && linkaddr_node_addr.u8[1] == SINK_ADDR1;
+
+  etimer_set(&timer, REPORT_FREQ*CLOCK_CONF_SECOND/2); // one reporting period of the motes.
+
+  while(1)
+  {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+    if (period.stats.count > 0)
+    {
+      if (is_sink)
+      {
+        printRollup(&period);
+      }
+      else
+      {
+        parent.u8[0] = ROLLUP_PARENT0;
+        parent.u8[1] = ROLLUP_PARENT1;
+        len = rollupPack(&period, buf);
+        packetbuf_copyfrom(buf, len);
+        unicast_send(&uc, &parent);
+      }
+      rollupInit(&period);
+    }
+
+    etimer_reset(&timer);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,415 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Report Codec, see report-codec.h                                                */
+/*                                                                                 */
+/***********************************************************************************/
+#include "report-codec.h"
+#include <string.h> // for memset(), memcpy().
+
+/***********************************************************************************/
+/* function to set up an encoder or decoder, the next report is a key frame */
+void codecInit(struct report_codec *c)
+{
+  memset(c, 0, sizeof(*c));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to round a value in lx to the fixed point of the codec */
+long codecQuantize(float value)
+{
+  float v = value*CODEC_SCALE;
+
+  if (v >= 0)
+    return (long)(v+0.5f);
+  else
+    return -(long)(0.5f-v);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to predict element i of a report from the previous report and */
+/* the elements before i, the same on both ends */
+static long getPrediction(const struct report_codec *c, const long X[], int i,
+                          int AggrElementsCount, int key)
+{
+  if (key)
+    return i == 0 ? 0 : X[i-1];
+
+  // no aggregation twice in a row: the window moved by REPORT_FREQ readings.
+  if (AggrElementsCount == WINDOW_LEN && c->prev_count == WINDOW_LEN)
+    return i < WINDOW_LEN-REPORT_FREQ ? c->prev[i+REPORT_FREQ] : X[i-1];
+
+  if (AggrElementsCount == c->prev_count)
+    return c->prev[i];
+
+  return i == 0 ? c->prev[0] : X[i-1];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to write an unsigned varint, returns the bytes written */
+int putVarint(unsigned char out[], unsigned long v)
+{
+  int n = 0;
+
+  while (v >= 0x80)
+  {
+    out[n++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (unsigned char)v;
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to read an unsigned varint, returns the bytes read, 0 if truncated */
+int getVarint(const unsigned char in[], int len, unsigned long *v)
+{
+  int n = 0, shift = 0;
+
+  *v = 0;
+  while (n < len && shift < 35)
+  {
+    *v |= (unsigned long)(in[n] & 0x7f) << shift;
+    if ((in[n++] & 0x80) == 0)
+      return n;
+    shift += 7;
+  }
+  return 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to write one residual, or count it into a run of zero residuals */
+/* returns the bytes written. */
+static int putResidual(unsigned char out[], int *run, long r)
+{
+  unsigned long z;
+  int n = 0;
+
+  if (r == 0)
+  {
+    (*run)++;
+    return 0;
+  }
+  if (*run > 0)
+  {
+    n += putVarint(out, ((unsigned long)*run << 1) | 1);
+    *run = 0;
+  }
+  z = r > 0 ? (unsigned long)r << 1 : ((unsigned long)(-r) << 1) - 1; // zigzag.
+  return n + putVarint(out+n, z << 1);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to write the pending run of zero residuals, returns the bytes written */
+static int putRun(unsigned char out[], int run)
+{
+  return run > 0 ? putVarint(out, ((unsigned long)run << 1) | 1) : 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to read the residual of the next of left elements */
+/* *run carries a run of zero residuals from one call to the next. Returns */
+/* the bytes read, -1 if malformed. */
+static int getResidual(const unsigned char in[], int len, int *run, int left, long *r)
+{
+  unsigned long v;
+  int n = 0, m;
+
+  if (*run == 0)
+  {
+    if ((m = getVarint(in, len, &v)) == 0)
+      return -1;
+    n += m;
+    if (v & 1)
+    {
+      *run = (int)(v >> 1);
+      if (*run < 1 || *run > left)
+        return -1;
+    }
+    else
+    {
+      v >>= 1;
+      *r = v & 1 ? -(long)((v+1) >> 1) : (long)(v >> 1); // zigzag.
+      return n;
+    }
+  }
+  (*run)--;
+  *r = 0;
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the fixed point value of the previous report at a reading */
+/* of its window, whatever its element count. */
+static long getPrevious(const struct report_codec *c, int reading)
+{
+  return c->prev[reading*c->prev_count/WINDOW_LEN];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to predict segment j, which starts at reading start, from the */
+/* previous report and the segments before j, the same on both ends */
+static long getSegmentPrediction(const struct report_codec *c, const long V[], int j,
+                                 int start, int key)
+{
+  if (key)
+    return j == 0 ? 0 : V[j-1];
+
+  // the previous report saw this reading REPORT_FREQ positions later.
+  if (start+REPORT_FREQ < WINDOW_LEN)
+    return getPrevious(c, start+REPORT_FREQ);
+
+  return V[j-1];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to encode one report */
+/* out must hold CODEC_MAX_BYTES; returns the encoded length in bytes. */
+int codecEncode(struct report_codec *c, const float X[], int AggrElementsCount,
+                unsigned char out[])
+{
+  long Q[WINDOW_LEN];
+  int key = c->since_key == 0;
+  int n, i, run = 0;
+
+  n = putVarint(out, ((unsigned long)AggrElementsCount << 1) | key);
+
+  for (i=0;i<AggrElementsCount;i++)
+  {
+    Q[i] = codecQuantize(X[i]);
+    n += putResidual(out+n, &run, Q[i] - getPrediction(c, Q, i, AggrElementsCount, key));
+  }
+  n += putRun(out+n, run);
+
+  memcpy(c->prev, Q, AggrElementsCount*sizeof(long));
+  c->prev_count = AggrElementsCount;
+  c->since_key = (c->since_key+1) % CODEC_KEYFRAME;
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to encode one report of adaptive aggregation */
+/* X[j] is the value of the j-th of SegmentsCount segments, Len[j] its */
+/* readings. The header carries WINDOW_LEN + SegmentsCount, followed by the */
+/* lengths of all segments but the last and the residuals of the values. */
+/* out must hold CODEC_MAX_BYTES; returns the encoded length in bytes. */
+int codecEncodeSegments(struct report_codec *c, const float X[],
+                        const unsigned char Len[], int SegmentsCount, unsigned char out[])
+{
+  long V[WINDOW_LEN];
+  int key = c->since_key == 0;
+  int n, j, i, start, run = 0;
+
+  // one segment per reading needs no lengths.
+  if (SegmentsCount == WINDOW_LEN)
+    return codecEncode(c, X, WINDOW_LEN, out);
+
+  n = putVarint(out, ((unsigned long)(WINDOW_LEN+SegmentsCount) << 1) | key);
+  for (j=0;j<SegmentsCount-1;j++)
+    n += putVarint(out+n, Len[j]);
+
+  for (j=0,start=0;j<SegmentsCount;start+=Len[j++])
+  {
+    V[j] = codecQuantize(X[j]);
+    n += putResidual(out+n, &run, V[j] - getSegmentPrediction(c, V, j, start, key));
+  }
+  n += putRun(out+n, run);
+
+  // the next report is predicted from the readings the segments stand for.
+  for (j=0,start=0;j<SegmentsCount;start+=Len[j++])
+  {
+    for (i=start;i<start+Len[j];i++)
+      c->prev[i] = V[j];
+  }
+  c->prev_count = WINDOW_LEN;
+  c->since_key = (c->since_key+1) % CODEC_KEYFRAME;
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to decode one report into fixed point elements */
+/* a report of adaptive aggregation comes out as its WINDOW_LEN readings. */
+/* Returns the bytes consumed, -1 if the report is malformed or is not a key */
+/* frame and the decoder has not seen one yet. */
+int codecDecode(struct report_codec *c, const unsigned char in[], int len,
+                long X[], int *AggrElementsCount)
+{
+  unsigned char Len[WINDOW_LEN];
+  long V[WINDOW_LEN];
+  unsigned long v;
+  long r;
+  int n, m, key, count, segments = 0, start = 0, i, j, run = 0;
+
+  if ((n = getVarint(in, len, &v)) == 0)
+    return -1;
+  key = v & 1;
+  count = (int)(v >> 1);
+  if (count >= 2*WINDOW_LEN || (!key && c->prev_count == 0) || (count == 0 && key))
+    return -1;
+
+  // a heartbeat: the previous report again.
+  if (count == 0)
+  {
+    memcpy(X, c->prev, c->prev_count*sizeof(long));
+    *AggrElementsCount = c->prev_count;
+    return n;
+  }
+
+  if (count > WINDOW_LEN)
+  {
+    segments = count - WINDOW_LEN;
+    for (j=0;j<segments-1;j++)
+    {
+      if ((m = getVarint(in+n, len-n, &v)) == 0 || v < 1 ||
+          v > (unsigned long)(WINDOW_LEN - start - (segments-1-j)))
+        return -1;
+      n += m;
+      Len[j] = (unsigned char)v;
+      start += Len[j];
+    }
+    Len[j] = (unsigned char)(WINDOW_LEN - start);
+
+    for (j=0,start=0;j<segments;start+=Len[j++])
+    {
+      if ((m = getResidual(in+n, len-n, &run, segments-j, &r)) < 0)
+        return -1;
+      n += m;
+      V[j] = getSegmentPrediction(c, V, j, start, key) + r;
+    }
+    for (j=0,start=0;j<segments;start+=Len[j++])
+    {
+      for (i=start;i<start+Len[j];i++)
+        X[i] = V[j];
+    }
+    count = WINDOW_LEN;
+  }
+  else
+  {
+    for (i=0;i<count;i++)
+    {
+      if ((m = getResidual(in+n, len-n, &run, count-i, &r)) < 0)
+        return -1;
+      n += m;
+      X[i] = getPrediction(c, X, i, count, key) + r;
+    }
+  }
+
+  memcpy(c->prev, X, count*sizeof(long));
+  c->prev_count = count;
+  *AggrElementsCount = count;
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the length of an encoded report without decoding it */
+/* returns the length in bytes, -1 if the report is malformed. */
+int codecReportLength(const unsigned char in[], int len)
+{
+  unsigned long v;
+  int n, m, count, i = 0;
+
+  if ((n = getVarint(in, len, &v)) == 0)
+    return -1;
+  count = (int)(v >> 1);
+  if (count >= 2*WINDOW_LEN)
+    return -1;
+
+  // the segment lengths of adaptive aggregation, then the residuals.
+  if (count > WINDOW_LEN)
+  {
+    count -= WINDOW_LEN;
+    for (i=0;i<count-1;i++)
+    {
+      if ((m = getVarint(in+n, len-n, &v)) == 0)
+        return -1;
+      n += m;
+    }
+    i = 0;
+  }
+
+  while (i < count)
+  {
+    if ((m = getVarint(in+n, len-n, &v)) == 0)
+      return -1;
+    n += m;
+    if (v & 1)
+    {
+      if ((v >> 1) < 1 || (v >> 1) > (unsigned long)(count-i))
+        return -1;
+      i += (int)(v >> 1);
+    }
+    else
+    {
+      i++;
+    }
+  }
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to tell whether a report differs from the previous one */
+/* X[] holds count elements, or count segments of Len[] readings when Len is */
+/* not NULL. Returns 1 when the report is due as a key frame, has another */
+/* size than the previous one or an element more than tolerance lx from it, */
+/* 0 when a heartbeat would do. */
+int codecChanged(const struct report_codec *c, const float X[], const unsigned char Len[],
+                 int count, float tolerance)
+{
+  long limit = codecQuantize(tolerance), d;
+  int i, j, start;
+
+  if (c->since_key == 0)
+    return 1;
+
+  if (Len == NULL || count == WINDOW_LEN)
+  {
+    if (count != c->prev_count)
+      return 1;
+    for (i=0;i<count;i++)
+    {
+      d = codecQuantize(X[i]) - c->prev[i];
+      if (d > limit || d < -limit)
+        return 1;
+    }
+    return 0;
+  }
+
+  // segments against the readings the previous report stands for.
+  if (c->prev_count != WINDOW_LEN)
+    return 1;
+  for (j=0,start=0;j<count;start+=Len[j++])
+  {
+    for (i=start;i<start+Len[j];i++)
+    {
+      d = codecQuantize(X[j]) - c->prev[i];
+      if (d > limit || d < -limit)
+        return 1;
+    }
+  }
+  return 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to encode a heartbeat in place of a report */
+/* it counts towards the next key frame but leaves the reference of the next */
+/* report as it is. Returns the encoded length in bytes, 1. */
+int codecEncodeHeartbeat(struct report_codec *c, unsigned char out[])
+{
+  c->since_key = (c->since_key+1) % CODEC_KEYFRAME;
+  return putVarint(out, 0);
+}
+/***********************************************************************************/
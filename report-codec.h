@@ -0,0 +1,124 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Report Codec                                                                    */
+/*                                                                                 */
+/* Compact encoding of the aggregated X[] vectors for transmission. Consecutive    */
+/* reports of a mote are strongly correlated, so each report is sent as the        */
+/* difference to a prediction made from the previous report:                       */
+/*                                                                                 */
+/* - values are rounded to fixed point (1/CODEC_SCALE lx);                         */
+/* - a no-aggregation report after another one predicts its older half from the    */
+/*   newer half of the previous report (the window moved by REPORT_FREQ readings), */
+/*   other reports of the same size predict each element from the same element of  */
+/*   the previous report, and the first element of a report of a new size from the */
+/*   first element of the previous one; the rest of the elements are predicted by  */
+/*   their neighbour;                                                              */
+/* - residuals are zigzag mapped and written as little-endian base-128 varints,    */
+/*   runs of zero residuals as a single varint;                                    */
+/* - a report of adaptive aggregation (AGGR_TOLERANCE) also carries the lengths of */
+/*   its segments and predicts each segment from the previous report at the same   */
+/*   reading, or from the segment before it in the newer half; it is decoded to    */
+/*   the WINDOW_LEN readings the segments stand for;                               */
+/* - a report that differs from the previous one by no more than the tolerance of  */
+/*   the mote (SUPPRESS_LIGHT) at any element may be sent as a one-byte heartbeat  */
+/*   instead, which the decoder turns back into the previous report.               */
+/*                                                                                 */
+/* Every CODEC_KEYFRAME-th report is a key frame predicted from nothing, so a      */
+/* receiver that missed reports resynchronizes. The encoder and the decoder each   */
+/* keep a struct report_codec; both are plain C without Contiki, the encoder runs  */
+/* on the mote (PROJECT_SOURCEFILES += report-codec.c) and the decoder on the host */
+/* (tools/codec.c).                                                                */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef REPORT_CODEC_H_
+#define REPORT_CODEC_H_
+
+#include "sensor-proc.h"
+
+#ifdef SENSOR_CONF_CODEC_SCALE
+#define CODEC_SCALE SENSOR_CONF_CODEC_SCALE // fixed point steps per lx.
+#else
+#define CODEC_SCALE 10 // 0.1 lx, finer than the 0.19 lx step of a 12-reading mean.
+#endif
+
+#ifdef SENSOR_CONF_CODEC_KEYFRAME
+#define CODEC_KEYFRAME SENSOR_CONF_CODEC_KEYFRAME // reports between key frames.
+#else
+#define CODEC_KEYFRAME 16
+#endif
+
+/* bytes of a varint of a value below v, for the bounds below. */
+#define CODEC_VARINT_BYTES(v) ((v) <= 0x80L ? 1 : (v) <= 0x4000L ? 2 : \
+                               (v) <= 0x200000L ? 3 : (v) <= 0x10000000L ? 4 : 5)
+
+/* bytes of the varint of one residual: a residual is the difference of two */
+/* values between 0 and full scale light, doubled by the zigzag mapping and */
+/* again by the run flag. A run of zero residuals takes no more per element. */
+#define CODEC_RESIDUAL_BYTES CODEC_VARINT_BYTES(4*9375L*CODEC_SCALE + 1)
+
+/* largest encoded report: the header varint, then either a residual per */
+/* element or, with adaptive aggregation of at most WINDOW_LEN-1 segments, a */
+/* 1-byte length for all but the last segment and a residual per segment. */
+#define CODEC_MAX_BYTES (CODEC_VARINT_BYTES(4L*WINDOW_LEN) + \
+                         (WINDOW_LEN-1)*CODEC_RESIDUAL_BYTES + \
+                         (WINDOW_LEN-2 > CODEC_RESIDUAL_BYTES ? WINDOW_LEN-2 : \
+                                                                CODEC_RESIDUAL_BYTES))
+
+/* change-driven reporting: with SUPPRESS 1 the mote sends a heartbeat for */
+/* a report whose every element is within SUPPRESS_LIGHT of the last report */
+/* sent, and prints a heartbeat line for a regression whose slope and offset */
+/* are within SUPPRESS_SLOPE and SUPPRESS_OFFSET of the last one printed. A */
+/* change of aggregation level is always reported, and so is a report due */
+/* as a key frame, which bounds the staleness at the sink. */
+#ifdef SENSOR_CONF_SUPPRESS
+#define SUPPRESS SENSOR_CONF_SUPPRESS // 1: heartbeats for unchanged results.
+#else
+#define SUPPRESS 0
+#endif
+
+#ifdef SENSOR_CONF_SUPPRESS_LIGHT
+#define SUPPRESS_LIGHT SENSOR_CONF_SUPPRESS_LIGHT // lx.
+#else
+#define SUPPRESS_LIGHT 10
+#endif
+
+#ifdef SENSOR_CONF_SUPPRESS_SLOPE
+#define SUPPRESS_SLOPE SENSOR_CONF_SUPPRESS_SLOPE // C per lx.
+#else
+#define SUPPRESS_SLOPE 0.0005
+#endif
+
+#ifdef SENSOR_CONF_SUPPRESS_OFFSET
+#define SUPPRESS_OFFSET SENSOR_CONF_SUPPRESS_OFFSET // C.
+#else
+#define SUPPRESS_OFFSET 0.1
+#endif
+
+STATIC_ASSERT(CODEC_KEYFRAME >= 1, keyframe_interval_positive);
+STATIC_ASSERT(9375L*CODEC_SCALE < 0x3fffffffL, codec_values_fit_long); // full scale light.
+
+struct report_codec
+{
+  long prev[WINDOW_LEN]; // fixed point elements of the previous report.
+  int prev_count;        // its element count, 0 before the first report.
+  int since_key;         // reports since the last key frame.
+};
+
+/* little-endian base-128 varints, also used by the other packet formats. */
+int putVarint(unsigned char out[], unsigned long v); // out needs 5 bytes.
+int getVarint(const unsigned char in[], int len, unsigned long *v);
+
+void codecInit(struct report_codec *c);
+long codecQuantize(float value);
+int codecEncode(struct report_codec *c, const float X[], int AggrElementsCount,
+                unsigned char out[]);
+int codecEncodeSegments(struct report_codec *c, const float X[],
+                        const unsigned char Len[], int SegmentsCount, unsigned char out[]);
+int codecDecode(struct report_codec *c, const unsigned char in[], int len,
+                long X[], int *AggrElementsCount);
+int codecReportLength(const unsigned char in[], int len);
+int codecChanged(const struct report_codec *c, const float X[], const unsigned char Len[],
+                 int count, float tolerance);
+int codecEncodeHeartbeat(struct report_codec *c, unsigned char out[]);
+
+#endif /* REPORT_CODEC_H_ */
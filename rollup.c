@@ -0,0 +1,205 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* In-Network Rollups, see rollup.h                                                */
+/*                                                                                 */
+/***********************************************************************************/
+#include "rollup.h"
+#include <string.h> // for memset(), memcpy().
+
+#define ROLLUP_VERSION 1
+#define SQRT2 1.41421356f
+
+/***********************************************************************************/
+/* function to find the histogram bin of a light reading */
+static int getBin(float x)
+{
+  float edge = 1;
+  int b;
+
+  if (x < 1)
+    return 0;
+  for (b=1;b<ROLLUP_BINS-1 && x >= 2*edge;b+=2) // two bins per octave.
+    edge *= 2;
+  if (b < ROLLUP_BINS-1 && x >= SQRT2*edge)
+    b++;
+  return b;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the lower edge of a histogram bin in lx */
+static float getBinLower(int b)
+{
+  float edge = 1;
+  int p;
+
+  if (b == 0)
+    return 0;
+  for (p=0;p<(b-1)/2;p++)
+    edge *= 2;
+  return b % 2 == 0 ? SQRT2*edge : edge;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up an empty summary */
+void rollupInit(struct rollup *r)
+{
+  memset(r, 0, sizeof(*r));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add the readings B[0..n-1] of one mote to a summary */
+void rollupAddWindow(struct rollup *r, const float B[], int n)
+{
+  int i;
+
+  if (n <= 0)
+    return;
+  statsAddBlock(&r->stats, B, n);
+  for (i=0;i<n;i++)
+    r->bins[getBin(B[i])]++;
+  r->motes++;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to merge another summary into r */
+void rollupMerge(struct rollup *r, const struct rollup *other)
+{
+  int b;
+
+  statsMerge(&r->stats, &other->stats);
+  r->motes += other->motes;
+  for (b=0;b<ROLLUP_BINS;b++)
+    r->bins[b] += other->bins[b];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to estimate quantile q (0 to 1) from the histogram sketch */
+/* linear inside the bin holding the quantile, clipped to min and max. */
+float rollupQuantile(const struct rollup *r, float q)
+{
+  float target, lo, hi;
+  unsigned long cum = 0;
+  int b;
+
+  if (r->stats.count == 0)
+    return 0;
+  target = q * r->stats.count;
+  for (b=0;b<ROLLUP_BINS-1;b++)
+  {
+    if (r->bins[b] > 0 && cum + r->bins[b] >= target)
+      break;
+    cum += r->bins[b];
+  }
+
+  lo = getBinLower(b);
+  hi = b < ROLLUP_BINS-1 ? getBinLower(b+1) : r->stats.max;
+  if (lo < r->stats.min)
+    lo = r->stats.min;
+  if (hi > r->stats.max)
+    hi = r->stats.max;
+  if (r->bins[b] == 0 || hi <= lo)
+    return lo;
+  return lo + (hi-lo) * (target-cum) / r->bins[b];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to pack a summary for the radio */
+/* version byte, varint count and motes, mean, M2, min and max as */
+/* little-endian floats, a 32-bit map of the non-empty bins and a varint per */
+/* non-empty bin. Bin counts above ROLLUP_BIN_MAX scale all bins down by the */
+/* same factor, a non-empty bin stays non-empty. out must hold */
+/* ROLLUP_MAX_BYTES; returns the packed length. */
+int rollupPack(const struct rollup *r, unsigned char out[])
+{
+  unsigned long map = 0, top = 0, count;
+  int n = 0, b, at;
+
+  for (b=0;b<ROLLUP_BINS;b++)
+  {
+    if (r->bins[b] > top)
+      top = r->bins[b];
+  }
+
+  out[n++] = ROLLUP_VERSION;
+  n += putVarint(out+n, r->stats.count);
+  n += putVarint(out+n, r->motes);
+  memcpy(out+n, &r->stats.mean, 4); // MSP430 and x86 are both little-endian.
+  memcpy(out+n+4, &r->stats.M2, 4);
+  memcpy(out+n+8, &r->stats.min, 4);
+  memcpy(out+n+12, &r->stats.max, 4);
+  n += 16;
+
+  at = n;
+  n += 4;
+  for (b=0;b<ROLLUP_BINS;b++)
+  {
+    if (r->bins[b] == 0)
+      continue;
+    map |= 1UL << b;
+    count = r->bins[b];
+    if (top > ROLLUP_BIN_MAX)
+    {
+      count = (unsigned long)((float)count * ROLLUP_BIN_MAX / top);
+      count = count > 0 ? count : 1;
+    }
+    n += putVarint(out+n, count);
+  }
+  for (b=0;b<4;b++)
+    out[at+b] = (unsigned char)(map >> 8*b);
+  return n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to unpack a summary packed by rollupPack() */
+/* bins scaled down by the packing are scaled back up to the count of the */
+/* summary, so summaries merge with their weight. returns the bytes */
+/* consumed, -1 if malformed. */
+int rollupUnpack(struct rollup *r, const unsigned char in[], int len)
+{
+  unsigned long map = 0, sum = 0;
+  int n = 1, m, b;
+
+  rollupInit(r);
+  if (len < 1 || in[0] != ROLLUP_VERSION)
+    return -1;
+  if ((m = getVarint(in+n, len-n, &r->stats.count)) == 0)
+    return -1;
+  n += m;
+  if ((m = getVarint(in+n, len-n, &r->motes)) == 0)
+    return -1;
+  n += m;
+  if (len-n < 16+4)
+    return -1;
+  memcpy(&r->stats.mean, in+n, 4);
+  memcpy(&r->stats.M2, in+n+4, 4);
+  memcpy(&r->stats.min, in+n+8, 4);
+  memcpy(&r->stats.max, in+n+12, 4);
+  n += 16;
+
+  for (b=0;b<4;b++)
+    map |= (unsigned long)in[n++] << 8*b;
+  for (b=0;b<ROLLUP_BINS;b++)
+  {
+    if ((map >> b & 1) == 0)
+      continue;
+    if ((m = getVarint(in+n, len-n, &r->bins[b])) == 0)
+      return -1;
+    n += m;
+    sum += r->bins[b];
+  }
+
+  if (sum > 0 && sum < r->stats.count)
+  {
+    for (b=0;b<ROLLUP_BINS;b++)
+      r->bins[b] = (unsigned long)((float)r->bins[b] * r->stats.count / sum + 0.5f);
+  }
+  return n;
+}
+/***********************************************************************************/
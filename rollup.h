@@ -0,0 +1,82 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* In-Network Rollups                                                              */
+/*                                                                                 */
+/* Instead of every mote sending its reports all the way to the sink, the motes    */
+/* of a collection tree send one summary of their newest readings per reporting    */
+/* period to their parent, and a parent (a relay node) merges the summaries of its */
+/* children before passing one on. The sink gets one summary per period for the    */
+/* whole tree, so the packets above the motes drop by the fan-out at every level.  */
+/*                                                                                 */
+/* A summary (struct rollup) holds the mergeable statistics of sensor-proc.h       */
+/* (count, mean, M2, min, max) of the light readings it covers, the number of      */
+/* motes merged into it, and a histogram sketch over logarithmic bins, two per     */
+/* octave, from which quantiles are estimated to within the width of a bin (41%).  */
+/* A packed summary always fits one packet: the bins span the range of the Sky     */
+/* light sensor and their counts are packed in two bytes at most, scaled down      */
+/* together on a relay whose summary covers more readings than that.               */
+/* Merging is associative and commutative, so the tree shape does not change the   */
+/* result beyond float rounding.                                                   */
+/*                                                                                 */
+/* Plain C without Contiki: sensor.c (built with SENSOR_CONF_ROLLUP 1) and relay.c */
+/* send and merge the summaries on the motes, tools/netsim.c simulates a whole     */
+/* tree on the host.                                                               */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef ROLLUP_H_
+#define ROLLUP_H_
+
+#include "sensor-proc.h"
+#include "transport.h"
+
+#ifdef SENSOR_CONF_ROLLUP
+#define ROLLUP SENSOR_CONF_ROLLUP // 1: motes send summaries to their parent, not reports.
+#else
+#define ROLLUP 0
+#endif
+
+#ifdef SENSOR_CONF_ROLLUP_CHANNEL
+#define ROLLUP_CHANNEL SENSOR_CONF_ROLLUP_CHANNEL // Rime channel of the summaries.
+#else
+#define ROLLUP_CHANNEL 147
+#endif
+
+#ifdef SENSOR_CONF_ROLLUP_PARENT0
+#define ROLLUP_PARENT0 SENSOR_CONF_ROLLUP_PARENT0 // Rime address of the parent node.
+#define ROLLUP_PARENT1 SENSOR_CONF_ROLLUP_PARENT1
+#else
+#define ROLLUP_PARENT0 SINK_ADDR0 // a flat tree, every mote a child of the sink.
+#define ROLLUP_PARENT1 SINK_ADDR1
+#endif
+
+/* histogram bins: bin 0 is [0, 1) lx, bin b > 0 starts at 2^((b-1)/2) lx; */
+/* the last, from 8192 lx, holds the top of the Sky light sensor (9373 lx). */
+#define ROLLUP_BINS 28
+
+/* largest bin count packed, the most a two-byte varint holds. */
+#define ROLLUP_BIN_MAX 16383
+
+/* largest packed summary: version, two varints, four floats, the 32-bit bin */
+/* map and a varint of at most two bytes per bin. A mote's summary of */
+/* REPORT_FREQ readings fills one bin or a few with one-byte counts: 24 bytes */
+/* for steady indoor light, one more per further bin. */
+#define ROLLUP_MAX_BYTES (1 + 2*5 + 4*4 + 4 + ROLLUP_BINS*2)
+
+STATIC_ASSERT(ROLLUP_BINS <= 32, bins_fit_the_bin_map);
+STATIC_ASSERT(ROLLUP_MAX_BYTES <= TRANSPORT_PAYLOAD, summary_fits_a_packet);
+
+struct rollup
+{
+  struct stats stats;   // of the readings covered.
+  unsigned long motes;  // motes merged.
+  unsigned long bins[ROLLUP_BINS];
+};
+
+void rollupInit(struct rollup *r);
+void rollupAddWindow(struct rollup *r, const float B[], int n);
+void rollupMerge(struct rollup *r, const struct rollup *other);
+float rollupQuantile(const struct rollup *r, float q);
+int rollupPack(const struct rollup *r, unsigned char out[]);
+int rollupUnpack(struct rollup *r, const unsigned char in[], int len);
+
+#endif /* ROLLUP_H_ */
@@ -0,0 +1,1406 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Sensor Data Processing                                                          */
+/*                                                                                 */
+/* Contiki independent part of the processing, see sensor-proc.h.                  */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include <stdio.h> // for printf().
+#include <string.h> // for memmove().
+
+/* inlining and unrolling the compiler must do, for kernels specialized on */
+/* constant arguments. */
+#ifdef __GNUC__
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+#if defined(__GNUC__) && __GNUC__ >= 8
+#define UNROLL _Pragma("GCC unroll 16")
+#else
+#define UNROLL
+#endif
+
+/* the hardware multiplier of the MSP430, used by the multiply-accumulate */
+/* helpers. */
+#ifdef __MSP430__
+#include <msp430.h>
+#endif
+#if defined(__MSP430_HAS_MPY__) || defined(__MSP430_HAS_MPY32__)
+#define MAC_HARDWARE 1
+#else
+#define MAC_HARDWARE 0
+#endif
+
+/***********************************************************************************/
+/* function to get the integer part of a floating point number */
+int d1(float f) // integer part.
+{
+  return((int)f);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the fractional part of a floating point number */
+/* upto 3 positions */
+unsigned int d2(float f) // fractional part.
+{
+  if (f>0)
+    return(1000*(f-d1(f)));
+  else
+    return(1000*(d1(f)-f));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to convert a temperature ADC reading to degrees C */
+float temperatureFromADC(int tempADC)
+{
+  // for simulation sky mote.
+  float temp_c = 0.04*tempADC-39.6; //skymote uses 12-bit ADC, or 0.04 resolution.
+
+  // for XM1000 mote.
+  //float temp_c = 0.01*tempADC-39.6; // xm1000 uses 14-bit ADC, or 0.01 resolution.
+
+  return temp_c;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to convert a light ADC reading to lux */
+float lightFromADC(int lightADC)
+{
+  float V_sensor = 1.5 * lightADC/4096;
+                                     // ADC-12 uses 1.5V_REF.
+  float I = V_sensor/100000;         // xm1000 uses 100kohm resistor.
+  float light_lx = 0.625*1e6*I*1000; // convert from current to light intensity.
+
+  return light_lx;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to round a value to a count of fixed point steps */
+/* per is the steps per unit; the count saturates at +-STEPS_MAX so the */
+/* difference of two counts fits 16 bits. */
+short getSteps(float x, float per)
+{
+  float v = x*per;
+
+  if (v >= STEPS_MAX)
+    return STEPS_MAX;
+  if (v <= -STEPS_MAX)
+    return -STEPS_MAX;
+  return v >= 0 ? (short)(v+0.5f) : -(short)(0.5f-v);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to check that sums of products of X[] - x0 fit the MAC */
+/* lo and hi are set to the range of X[], the helpers are then to be */
+/* called with x0 = lo + (hi-lo)/2. Returns 1 when n * (hi-x0)^2 stays */
+/* below 2^31. */
+int stepsFitMac(const short X[], int n, short *lo, short *hi)
+{
+  long span;
+  int i;
+
+  *lo = *hi = X[0];
+  for (i=1;i<n;i++)
+  {
+    if (X[i] < *lo)
+      *lo = X[i];
+    if (X[i] > *hi)
+      *hi = X[i];
+  }
+  span = *hi - (*lo + (*hi-*lo)/2);
+  return span*span <= 0x7fffffffL / n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the sum and the sum of squares of X[i] - x0 */
+/* on the MSP430 the squares are accumulated by the MAC of the hardware */
+/* multiplier, with interrupts off so that a handler multiplying in */
+/* between does not clobber the accumulator. The high word is shifted as */
+/* unsigned, a negative sum would overflow a signed shift. */
+void macSumSquares(const short X[], int n, short x0, long *sum, long *sumsq)
+{
+  long s = 0;
+  short d;
+  int i;
+#if MAC_HARDWARE
+  unsigned int sr = __read_status_register();
+
+  __dint();
+  __nop();
+  RESLO = 0;
+  RESHI = 0;
+  for (i=0;i<n;i++)
+  {
+    d = X[i] - x0;
+    s += d;
+    MACS = d;
+    OP2 = d;
+  }
+  *sumsq = (long)((unsigned long)RESHI << 16 | RESLO);
+  if (sr & GIE)
+    __eint();
+#else
+  long q = 0;
+
+  for (i=0;i<n;i++)
+  {
+    d = X[i] - x0;
+    s += d;
+    q += (long)d * d;
+  }
+  *sumsq = q;
+#endif
+  *sum = s;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the sum of the products (X[i] - x0) * (Y[i] - y0) */
+/* on the MAC like macSumSquares(). */
+long macDot(const short X[], const short Y[], int n, short x0, short y0)
+{
+  int i;
+#if MAC_HARDWARE
+  unsigned int sr = __read_status_register();
+  long q;
+
+  __dint();
+  __nop();
+  RESLO = 0;
+  RESHI = 0;
+  for (i=0;i<n;i++)
+  {
+    MACS = X[i] - x0;
+    OP2 = Y[i] - y0;
+  }
+  q = (long)((unsigned long)RESHI << 16 | RESLO);
+  if (sr & GIE)
+    __eint();
+  return q;
+#else
+  long q = 0;
+
+  for (i=0;i<n;i++)
+  {
+    q += (long)(short)(X[i] - x0) * (short)(Y[i] - y0);
+  }
+  return q;
+#endif
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the square root */
+float getSqrt(float S)
+{
+  float difference = 0.0;
+  float error = 0.001;  // error tolerance.
+  float x = 10.0;       // initial guess.
+  int i;
+  for (i=0; i<50; i++)  // looping 50 times.
+  {
+    x = 0.5 * (x + S/x);
+    difference = x*x - S;
+    if (difference<0) difference = -difference;
+    if (difference<error) break; // the difference is deemed small enough.
+  }
+  return x;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to print the elements of an array */
+void printArray(char ArrName[5], float Arr[], int ArrElementsCount)
+{
+  int i;
+  printf("\n%s = [", ArrName);
+  for (i=0;i<ArrElementsCount;i++)
+  {
+    printf("%d.%03u", d1(Arr[i]), d2(Arr[i]));
+    if (i<(ArrElementsCount-1))
+    {
+      printf (", ");
+    }
+  }
+  printf("]\n");
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to bring the elements of the given ranks into place */
+/* Ranks must be in ascending order; on return A[r] holds the value it would */
+/* hold if A were fully sorted, for every requested rank r. All the requested */
+/* ranks are resolved in one partition pass (multi-quickselect). */
+static void selectRanks(float A[], int left, int right,
+                        int Ranks[], int first, int last)
+{
+  float pivot, intermed;
+  int i, j, mid, split_lo, split_hi;
+
+  while (first<=last && left<right)
+  {
+    // median-of-three pivot, keeps sorted windows away from the worst case.
+    mid = left + (right-left)/2;
+    pivot = A[mid];
+    if ((A[left] > pivot) != (A[left] > A[right]))
+      pivot = A[left];
+    else if ((A[right] > pivot) != (A[right] > A[left]))
+      pivot = A[right];
+
+    // after partitioning, A[left..j] <= pivot, A[i..right] >= pivot and
+    // anything strictly between j and i equals the pivot.
+    i = left;
+    j = right;
+    while (i<=j)
+    {
+      while (A[i] < pivot) i++;
+      while (A[j] > pivot) j--;
+      if (i<=j)
+      {
+        intermed = A[i];
+        A[i] = A[j];
+        A[j] = intermed;
+        i++;
+        j--;
+      }
+    }
+
+    // split the pending ranks between the two sides.
+    split_lo = first;
+    while (split_lo<=last && Ranks[split_lo]<=j) split_lo++;
+    split_hi = split_lo;
+    while (split_hi<=last && Ranks[split_hi]<i) split_hi++;
+
+    // recurse into the side with fewer ranks, iterate on the other one.
+    if (split_lo-first < last-split_hi+1)
+    {
+      selectRanks(A, left, j, Ranks, first, split_lo-1);
+      left = i;
+      first = split_hi;
+    }
+    else
+    {
+      selectRanks(A, i, right, Ranks, split_hi, last);
+      right = j;
+      last = split_lo-1;
+    }
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the median */
+/* TS is left untouched, the selection runs on a copy in Scratch, which must */
+/* hold at least TSElementsCount elements. */
+float getMedian(const float TS[], int TSElementsCount, float Scratch[])
+{
+  int Ranks[2];
+  int i;
+
+  if (TSElementsCount<=0)
+    return 0;
+
+  for (i=0;i<TSElementsCount;i++)
+  {
+    Scratch[i] = TS[i];
+  }
+
+  // find median value from the partially sorted copy.
+  Ranks[0] = (TSElementsCount-1)/2;
+  Ranks[1] = TSElementsCount/2;
+  selectRanks(Scratch, 0, TSElementsCount-1, Ranks, 0, 1);
+
+  if (TSElementsCount % 2 == 0)
+    return (Scratch[Ranks[0]] + Scratch[Ranks[1]])/2;
+  else
+    return Scratch[Ranks[0]];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find several quantiles in one pass */
+/* Q[] holds QCount quantiles in [0,1], in any order; Result[] receives the */
+/* matching values, linearly interpolated between the neighbouring ranks */
+/* (Q = 0.5 is the median). TS is left untouched, Scratch must hold at least */
+/* TSElementsCount elements. Returns the number of quantiles computed, which */
+/* is capped at QUANTILES_MAX. */
+int getQuantiles(const float TS[], int TSElementsCount, float Scratch[],
+                 const float Q[], float Result[], int QCount)
+{
+  int Ranks[2*QUANTILES_MAX];
+  int RanksCount = 0;
+  int i, j, lo;
+  float pos;
+
+  if (QCount>QUANTILES_MAX)
+    QCount = QUANTILES_MAX;
+  if (TSElementsCount<=0)
+  {
+    for (i=0;i<QCount;i++)
+      Result[i] = 0;
+    return QCount;
+  }
+
+  for (i=0;i<TSElementsCount;i++)
+  {
+    Scratch[i] = TS[i];
+  }
+
+  // collect the two ranks around every quantile, sorted and de-duplicated.
+  for (i=0;i<QCount;i++)
+  {
+    pos = Q[i] * (TSElementsCount-1);
+    if (pos<0) pos = 0;
+    if (pos>TSElementsCount-1) pos = TSElementsCount-1;
+    lo = (int)pos;
+    for (j=0;j<2;j++)
+    {
+      int r = (lo+j<TSElementsCount) ? lo+j : lo;
+      int k = RanksCount;
+      while (k>0 && Ranks[k-1]>r) k--;
+      if (k>0 && Ranks[k-1]==r) continue;
+      memmove(&Ranks[k+1], &Ranks[k], (RanksCount-k)*sizeof(int));
+      Ranks[k] = r;
+      RanksCount++;
+    }
+  }
+
+  selectRanks(Scratch, 0, TSElementsCount-1, Ranks, 0, RanksCount-1);
+
+  for (i=0;i<QCount;i++)
+  {
+    pos = Q[i] * (TSElementsCount-1);
+    if (pos<0) pos = 0;
+    if (pos>TSElementsCount-1) pos = TSElementsCount-1;
+    lo = (int)pos;
+    if (lo+1<TSElementsCount)
+      Result[i] = Scratch[lo] + (pos-lo)*(Scratch[lo+1]-Scratch[lo]);
+    else
+      Result[i] = Scratch[lo];
+  }
+  return QCount;
+}
+/***********************************************************************************/ 
+
+/***********************************************************************************/
+/* scratch arena, see sensor-proc.h */
+void arenaInit(struct arena *a, void *mem, unsigned int size)
+{
+  a->mem = (unsigned char *)mem;
+  a->size = size;
+  a->top = 0;
+  a->peak = 0;
+}
+
+void *arenaAlloc(struct arena *a, unsigned int bytes)
+{
+  void *p;
+
+  bytes = (bytes + ARENA_ALIGN-1) / ARENA_ALIGN * ARENA_ALIGN;
+  if (bytes > a->size - a->top)
+    return NULL;
+  p = a->mem + a->top;
+  a->top += bytes;
+  if (a->top > a->peak)
+    a->peak = a->top;
+  return p;
+}
+
+unsigned int arenaMark(struct arena *a)
+{
+  return a->top;
+}
+
+void arenaRelease(struct arena *a, unsigned int mark)
+{
+  if (mark < a->top)
+    a->top = mark;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up empty summary statistics */
+void statsInit(struct stats *s)
+{
+  memset(s, 0, sizeof(*s));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add one reading to summary statistics (Welford) */
+void statsAdd(struct stats *s, float x)
+{
+  float delta;
+
+  if (s->count == 0)
+  {
+    s->min = x;
+    s->max = x;
+  }
+  if (x < s->min)
+    s->min = x;
+  if (x > s->max)
+    s->max = x;
+  s->count++;
+  delta = x - s->mean;
+  s->mean += delta / s->count;
+  s->M2 += delta * (x - s->mean);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add a block of readings to summary statistics */
+/* the block is summarized with two passes (sum, then squared distances to */
+/* the mean) and merged in; into empty statistics this is exactly the */
+/* arithmetic of the original activity measurement. */
+void statsAddBlock(struct stats *s, const float B[], int n)
+{
+  struct stats block;
+  float Sum, Mean, SumofDistSquares;
+  int i;
+
+  if (n <= 0)
+    return;
+
+  Sum = 0;
+  block.min = B[0];
+  block.max = B[0];
+  for (i=0;i<n;i++)
+  {
+    Sum = Sum + B[i];
+    if (B[i] < block.min)
+      block.min = B[i];
+    if (B[i] > block.max)
+      block.max = B[i];
+  }
+  Mean = Sum/n;
+
+  SumofDistSquares = 0;
+  for (i=0;i<n;i++)
+  {
+    SumofDistSquares = SumofDistSquares + ((B[i]-Mean)*(B[i]-Mean));
+  }
+
+  block.count = n;
+  block.mean = Mean;
+  block.M2 = SumofDistSquares;
+  statsMerge(s, &block);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add a block of readings given in sensor steps */
+/* the integer counterpart of statsAddBlock(): the sums of the steps are */
+/* exact, taken on the multiply-accumulate helpers, and M2 is formed from */
+/* them as n*sum(x^2) - sum(x)^2 in 64 bits before the one conversion to */
+/* float. step is the size of a step; a block too wide for the MAC is */
+/* added reading by reading in float instead. */
+void statsAddSteps(struct stats *s, const short Q[], int n, float step)
+{
+  struct stats block;
+  long sum, sumsq;
+  short lo, hi, x0;
+  int i;
+
+  if (n <= 0)
+    return;
+
+  if (!stepsFitMac(Q, n, &lo, &hi))
+  {
+    for (i=0;i<n;i++)
+      statsAdd(s, Q[i]*step);
+    return;
+  }
+  x0 = lo + (hi-lo)/2;
+  macSumSquares(Q, n, x0, &sum, &sumsq);
+
+  block.count = n;
+  block.mean = (x0 + (float)sum/n) * step;
+  block.M2 = (float)((long long)n*sumsq - (long long)sum*sum) / n * step*step;
+  block.min = lo * step;
+  block.max = hi * step;
+  statsMerge(s, &block);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to merge other into s */
+/* pairwise update of mean and M2 (Chan et al.), associative and commutative */
+/* up to float rounding. */
+void statsMerge(struct stats *s, const struct stats *other)
+{
+  float delta, n;
+
+  if (other->count == 0)
+    return;
+  if (s->count == 0)
+  {
+    *s = *other;
+    return;
+  }
+
+  n = (float)s->count + other->count;
+  delta = other->mean - s->mean;
+  s->M2 += other->M2 + delta*delta * ((float)s->count * other->count / n);
+  s->mean += delta * other->count / n;
+  s->count += other->count;
+  if (other->min < s->min)
+    s->min = other->min;
+  if (other->max > s->max)
+    s->max = other->max;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the standard deviation per reading of summary statistics */
+/* unlike getStdDev(), M2 is divided by the count so summaries of different */
+/* sizes are comparable. */
+float statsStdDev(const struct stats *s)
+{
+  if (s->count == 0)
+    return 0;
+  return getSqrt(s->M2 / s->count);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to calculate the standard deviation of the light window */
+/* kept as the square root of the summed squared distances, which is what */
+/* the aggregation thresholds were tuned on. */
+float getStdDev(const float B[])
+{
+  struct stats s;
+
+  statsInit(&s);
+  statsAddBlock(&s, B, WINDOW_LEN);
+  return getSqrt(s.M2);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up a classifier at the lowest level */
+/* Thresholds[] holds the ACTIVITY_LEVELS-1 std-devs between the levels, */
+/* in increasing order; hysteresis is the width of the band above each as */
+/* a fraction of it. */
+void classifierInit(struct classifier *c, const float Thresholds[], float hysteresis,
+                    int min_dwell)
+{
+  int i;
+
+  for (i=0;i<ACTIVITY_LEVELS-1;i++)
+  {
+    c->up[i] = Thresholds[i] * (1 + hysteresis);
+    c->down[i] = Thresholds[i];
+  }
+  c->min_dwell = min_dwell;
+  c->level = 0;
+  c->dwell = min_dwell; // free to move from the first report on.
+  c->changes = 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to categorize the activity by standard deviation */
+/* returns the count of aggregated elements - 1, 3, or WINDOW_LEN. */
+int classifierUpdate(struct classifier *c, float StdDev)
+{
+  static const int AggrElementsCounts[ACTIVITY_LEVELS] = {1, 3, WINDOW_LEN};
+  int level = c->level;
+
+  while (level<ACTIVITY_LEVELS-1 && StdDev>=c->up[level])
+    level++;
+  if (level==c->level)
+  {
+    while (level>0 && StdDev<c->down[level-1])
+      level--;
+    if (c->dwell<c->min_dwell)
+      level = c->level; // held for too short to step down.
+  }
+
+  if (level!=c->level)
+  {
+    c->level = level;
+    c->dwell = 1;
+    c->changes++;
+  }
+  else if (c->dwell<c->min_dwell)
+  {
+    c->dwell++;
+  }
+  return AggrElementsCounts[c->level];
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to reduce every block of len readings of the light window */
+/* to one element of X. Always inlined with len and reduce as constants, so */
+/* each aggregation level compiles to its own straight loop, as tight as */
+/* the unrolled code it replaces. */
+static ALWAYS_INLINE void reduceBlocks(const float B[], float X[], int len, int reduce)
+{
+  float Scratch[WINDOW_LEN];
+  float x;
+  int b, i;
+
+  UNROLL
+  for (b=0;b<WINDOW_LEN/len;b++,B+=len)
+  {
+    x = B[0];
+    switch (reduce)
+    {
+      case AGGR_MEAN:
+        UNROLL
+        for (i=1;i<len;i++)
+          x += B[i];
+        x /= len;
+        break;
+      case AGGR_MIN:
+        UNROLL
+        for (i=1;i<len;i++)
+          x = B[i]<x ? B[i] : x;
+        break;
+      case AGGR_MAX:
+        UNROLL
+        for (i=1;i<len;i++)
+          x = B[i]>x ? B[i] : x;
+        break;
+      case AGGR_MEDIAN:
+        x = getMedian(B, len, Scratch);
+        break;
+    }
+    X[b] = x;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to pick the copy of the kernel for an aggregation level */
+/* the levels of the classifier get their own copies, any other divisor */
+/* of WINDOW_LEN the generic one. */
+static ALWAYS_INLINE void reduceLevel(const float B[], float X[], int AggrElementsCount,
+                                      int reduce)
+{
+  switch (AggrElementsCount)
+  {
+    case 1:
+      reduceBlocks(B, X, WINDOW_LEN, reduce);
+      break;
+    case 3:
+      reduceBlocks(B, X, WINDOW_LEN/3, reduce);
+      break;
+    case WINDOW_LEN:
+      reduceBlocks(B, X, 1, reduce);
+      break;
+    default:
+      reduceBlocks(B, X, WINDOW_LEN/AggrElementsCount, reduce);
+      break;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to aggregate the light window into X by blocks */
+/* AggrElementsCount must divide WINDOW_LEN; each of the AggrElementsCount */
+/* blocks of consecutive readings becomes its mean, min, max or median */
+/* (reduce is one of the AGGR_ codes). */
+void aggregateBlocks(const float B[], float X[], int AggrElementsCount, int reduce)
+{
+  switch (reduce)
+  {
+    case AGGR_MIN:
+      reduceLevel(B, X, AggrElementsCount, AGGR_MIN);
+      break;
+    case AGGR_MAX:
+      reduceLevel(B, X, AggrElementsCount, AGGR_MAX);
+      break;
+    case AGGR_MEDIAN:
+      reduceLevel(B, X, AggrElementsCount, AGGR_MEDIAN);
+      break;
+    default:
+      reduceLevel(B, X, AggrElementsCount, AGGR_MEAN);
+      break;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to aggregate the light window into X */
+/* by AGGR_REDUCE, the block mean unless configured otherwise; only that */
+/* kernel is built into the mote. */
+void aggregate(const float B[], float X[], int AggrElementsCount)
+{
+  reduceLevel(B, X, AggrElementsCount, AGGR_REDUCE);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to cut the light window into segments of constant value */
+/* every segment is extended while its readings stay within tolerance of */
+/* the middle of their range, which is the segment's value in X; Len gets */
+/* the readings of each segment. Taking the longest segment every time */
+/* gives the fewest segments for the tolerance. Returns the segment count. */
+int segmentWindow(const float B[], float tolerance, float X[], unsigned char Len[])
+{
+  float min, max;
+  int count = 0, start, i;
+
+  for (start=0;start<WINDOW_LEN;start=i)
+  {
+    min = max = B[start];
+    for (i=start+1;i<WINDOW_LEN;i++)
+    {
+      if (B[i]<min && max-B[i] > 2*tolerance)
+        break;
+      if (B[i]>max && B[i]-min > 2*tolerance)
+        break;
+      min = B[i]<min ? B[i] : min;
+      max = B[i]>max ? B[i] : max;
+    }
+    X[count] = (min+max)/2;
+    Len[count++] = (unsigned char)(i-start);
+  }
+  return count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to fit Temperature = offset + slope * Light by least squares */
+/* W holds the weight of every reading, NULL weighs them all the same. The */
+/* sums are taken around the means, which a float of the mote keeps exact */
+/* enough where raw sums of x^2 would cancel out. Returns WINDOW_LEN. */
+int getLeastSquares(const float B[], const float T[], const float W[],
+                    float *slope, float *offset)
+{
+  float w, sw = 0, mb = 0, mt = 0, sbb = 0, sbt = 0, db;
+  int i;
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    w = W != NULL ? W[i] : 1;
+    sw += w;
+    mb += w * B[i];
+    mt += w * T[i];
+  }
+  mb /= sw;
+  mt /= sw;
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    w = W != NULL ? W[i] : 1;
+    db = B[i] - mb;
+    sbb += w * db * db;
+    sbt += w * db * (T[i] - mt);
+  }
+
+  // constant light explains nothing, the fit is the mean temperature.
+  *slope = sbb > 0 ? sbt / sbb : 0;
+  *offset = mt - *slope * mb;
+  return WINDOW_LEN;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to fit Temperature = offset + slope * Light by least squares on */
+/* readings in sensor steps */
+/* the integer counterpart of getLeastSquares() without weights: the sums */
+/* of the steps are exact, taken on the multiply-accumulate helpers, and */
+/* the centered sums n*sum(b^2) - sum(b)^2 and n*sum(b t) - sum(b) sum(t) */
+/* are formed in 64 bits, so the slope costs one division. Returns */
+/* WINDOW_LEN, or -1 when the window is too wide for the MAC and the float */
+/* fit is needed. */
+int getLeastSquaresSteps(const short QB[], const short QT[], float *slope,
+                         float *offset)
+{
+  long sb, sbb, st, stt, sbt;
+  long long cbb, cbt;
+  short blo, bhi, tlo, thi, b0, t0;
+
+  if (!stepsFitMac(QB, WINDOW_LEN, &blo, &bhi) || !stepsFitMac(QT, WINDOW_LEN, &tlo, &thi))
+    return -1;
+  b0 = blo + (bhi-blo)/2;
+  t0 = tlo + (thi-tlo)/2;
+  macSumSquares(QB, WINDOW_LEN, b0, &sb, &sbb);
+  macSumSquares(QT, WINDOW_LEN, t0, &st, &stt);
+  sbt = macDot(QB, QT, WINDOW_LEN, b0, t0);
+
+  cbb = (long long)WINDOW_LEN*sbb - (long long)sb*sb;
+  cbt = (long long)WINDOW_LEN*sbt - (long long)sb*st;
+
+  // constant light explains nothing, the fit is the mean temperature.
+  *slope = cbb > 0 ? (float)cbt / (float)cbb * (float)(TEMP_STEP/LIGHT_STEP) : 0;
+  *offset = (t0 + (float)st/WINDOW_LEN) * (float)TEMP_STEP -
+            *slope * (b0 + (float)sb/WINDOW_LEN) * (float)LIGHT_STEP;
+  return WINDOW_LEN;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the slopes of all pairs of different light as fractions */
+/* N[k]/D[k] of fixed point steps, D[k] > 0, pairs (i, j), i < j, in the order */
+/* of nested loops over i and j, from the readings in steps QB and QT. One */
+/* flat loop over the PAIR_COUNT pairs steps i and j along, without a table */
+/* in RAM, and is integer subtraction only. Every pair is stored and the */
+/* count only advanced past a pair of different light, so equal readings */
+/* cost no branch. N and D must hold PAIR_COUNT elements; returns the number */
+/* of slopes. */
+static int getPairFractions(const short QB[], const short QT[], short N[], short D[])
+{
+  short db, dt;
+  int count = 0, i, j, k;
+
+  for (k=0, i=0, j=1;k<PAIR_COUNT;k++)
+  {
+    db = QB[j] - QB[i];
+    dt = QT[j] - QT[i];
+    N[count] = db > 0 ? dt : -dt;
+    D[count] = db > 0 ? db : -db;
+    count += db != 0;
+    if (++j == WINDOW_LEN)
+    {
+      i++;
+      j = i+1;
+    }
+  }
+  return count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to compare the slopes n1/d1 and n2/d2, d1 and d2 > 0, without */
+/* dividing */
+/* 16 x 16 bit products, exact in a long. */
+static ALWAYS_INLINE int slopeLess(short n1, short d1, short n2, short d2)
+{
+  return (long)n1*d2 < (long)n2*d1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to bring the slopes N[]/D[] of the given ranks into place */
+/* selectRanks() on fractions, compared by cross-multiplication. */
+static void selectSlopeRanks(short N[], short D[], int left, int right,
+                             int Ranks[], int first, int last)
+{
+  short pn, pd, intermed;
+  int i, j, mid, split_lo, split_hi;
+
+  while (first<=last && left<right)
+  {
+    // median-of-three pivot, keeps sorted windows away from the worst case.
+    mid = left + (right-left)/2;
+    pn = N[mid];
+    pd = D[mid];
+    if (slopeLess(pn, pd, N[left], D[left]) != slopeLess(N[right], D[right], N[left], D[left]))
+    {
+      pn = N[left];
+      pd = D[left];
+    }
+    else if (slopeLess(pn, pd, N[right], D[right]) !=
+             slopeLess(N[left], D[left], N[right], D[right]))
+    {
+      pn = N[right];
+      pd = D[right];
+    }
+
+    i = left;
+    j = right;
+    while (i<=j)
+    {
+      while (slopeLess(N[i], D[i], pn, pd)) i++;
+      while (slopeLess(pn, pd, N[j], D[j])) j--;
+      if (i<=j)
+      {
+        intermed = N[i]; N[i] = N[j]; N[j] = intermed;
+        intermed = D[i]; D[i] = D[j]; D[j] = intermed;
+        i++;
+        j--;
+      }
+    }
+
+    // split the pending ranks between the two sides.
+    split_lo = first;
+    while (split_lo<=last && Ranks[split_lo]<=j) split_lo++;
+    split_hi = split_lo;
+    while (split_hi<=last && Ranks[split_hi]<i) split_hi++;
+
+    // recurse into the side with fewer ranks, iterate on the other one.
+    if (split_lo-first < last-split_hi+1)
+    {
+      selectSlopeRanks(N, D, left, j, Ranks, first, split_lo-1);
+      left = i;
+      first = split_hi;
+    }
+    else
+    {
+      selectSlopeRanks(N, D, i, right, Ranks, split_hi, last);
+      right = j;
+      last = split_lo-1;
+    }
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the median of the slopes N[]/D[] */
+/* the fractions are ranked by cross-multiplication and the median is */
+/* divided out once, the mean of the middle two as (n1 d2 + n2 d1) / 2 d1 d2. */
+/* Returns C per lx. */
+static float getMedianSlope(short N[], short D[], int count)
+{
+  int Ranks[2];
+
+  if (count<=0)
+    return 0;
+
+  Ranks[0] = (count-1)/2;
+  Ranks[1] = count/2;
+  selectSlopeRanks(N, D, 0, count-1, Ranks, 0, 1);
+
+  return ((float)N[Ranks[0]]*D[Ranks[1]] + (float)N[Ranks[1]]*D[Ranks[0]]) /
+         ((float)D[Ranks[0]]*D[Ranks[1]]) * (float)(TEMP_STEP/(2*LIGHT_STEP));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to fit Temperature = offset + slope * Light by Theil-Sen */
+/* the slope is the median of the pairwise slopes, taken on the same readings */
+/* in sensor steps QB and QT as the pipeline keeps them, the offset the median */
+/* of T[i] - slope * B[i]. The buffers come from the arena */
+/* (THEILSEN_SCRATCH_SIZE) and are released before returning. Returns the */
+/* number of slopes used, or -1 when the arena is too small. */
+int getTheilSen(const float B[], const float T[], const short QB[], const short QT[],
+                struct arena *a, float *median_slope, float *median_offset)
+{
+  float *offsets, *median_scratch;
+  short *N, *D;
+  int slopes_count;
+  unsigned int mark;
+  int i;
+
+  mark = arenaMark(a);
+  N = arenaAlloc(a, ARENA_BYTES(PAIR_COUNT, short));
+  D = arenaAlloc(a, ARENA_BYTES(PAIR_COUNT, short));
+  offsets = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  median_scratch = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  if (median_scratch == NULL)
+  {
+    arenaRelease(a, mark);
+    return -1;
+  }
+
+  slopes_count = getPairFractions(QB, QT, N, D);
+  *median_slope = getMedianSlope(N, D, slopes_count);
+
+  for (i=0;i<WINDOW_LEN;i++) 
+  {
+    offsets[i] = T[i] - *median_slope * B[i];
+  }
+  *median_offset = getMedian(offsets,WINDOW_LEN,median_scratch);
+
+  arenaRelease(a, mark);
+  return slopes_count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to fit Temperature = offset + slope * Light by Siegel's repeated */
+/* median */
+/* the slope is the median over the readings of the median slope from each */
+/* reading to the others, in sensor steps QB and QT like getTheilSen(), the */
+/* offset the median of T[i] - slope * B[i]. The buffers come from the arena */
+/* (SIEGEL_SCRATCH_SIZE) and are released before returning. Returns the */
+/* number of readings with a slope, or -1 when the arena is too small. */
+int getSiegel(const float B[], const float T[], const short QB[], const short QT[],
+              struct arena *a, float *median_slope, float *median_offset)
+{
+  float *slopes, *medians, *median_scratch;
+  int slopes_count, medians_count = 0;
+  unsigned int mark;
+  int i, j;
+
+  mark = arenaMark(a);
+  slopes = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  medians = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  median_scratch = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  if (median_scratch == NULL)
+  {
+    arenaRelease(a, mark);
+    return -1;
+  }
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    slopes_count = 0;
+    for (j=0;j<WINDOW_LEN;j++)
+    {
+      if (QB[i] != QB[j])
+      {
+        slopes[slopes_count++] = (float)(QT[j] - QT[i]) / (QB[j] - QB[i]);
+      }
+    }
+    if (slopes_count > 0)
+      medians[medians_count++] = getMedian(slopes,slopes_count,median_scratch);
+  }
+  *median_slope = getMedian(medians,medians_count,median_scratch) *
+                  (float)(TEMP_STEP/LIGHT_STEP);
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    slopes[i] = T[i] - *median_slope * B[i];
+  }
+  *median_offset = getMedian(slopes,WINDOW_LEN,median_scratch);
+
+  arenaRelease(a, mark);
+  return medians_count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to fit Temperature = offset + slope * Light by any method */
+/* QB and QT are the readings in sensor steps (getSteps()), a the scratch, */
+/* REGRESS_SCRATCH_SIZE(method) bytes; both are only used by the median */
+/* methods. Returns the count of the fit, also in r->count. */
+int regress(const float B[], const float T[], const short QB[], const short QT[],
+            int method, struct arena *a, struct regression *r)
+{
+  float W[WINDOW_LEN];
+  int i;
+
+  r->method = method;
+  switch (method)
+  {
+    case REGRESS_WEIGHTED:
+      W[WINDOW_LEN-1] = 1;
+      for (i=WINDOW_LEN-2;i>=0;i--)
+        W[i] = W[i+1] * REGRESS_DECAY;
+      r->count = getLeastSquares(B, T, W, &r->slope, &r->offset);
+      break;
+    case REGRESS_THEILSEN:
+      r->count = getTheilSen(B, T, QB, QT, a, &r->slope, &r->offset);
+      break;
+    case REGRESS_SIEGEL:
+      r->count = getSiegel(B, T, QB, QT, a, &r->slope, &r->offset);
+      break;
+    default:
+      r->method = REGRESS_OLS;
+      r->count = getLeastSquares(B, T, NULL, &r->slope, &r->offset);
+      break;
+  }
+  return r->count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to name a regression method */
+const char *regressName(int method)
+{
+  switch (method)
+  {
+    case REGRESS_WEIGHTED:
+      return "Weighted Least Squares";
+    case REGRESS_THEILSEN:
+      return "Theil-Sen Estimator";
+    case REGRESS_SIEGEL:
+      return "Siegel Repeated Median";
+    default:
+      return "Ordinary Least Squares";
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to derive the estimated temperature vector */
+/* values are calculated using the linear equation. */
+void getEstimate(const float B[], float median_slope, float median_offset,
+                 float EstT[])
+{
+  int i;
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    EstT[i] = median_slope * B[i] + median_offset;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the anomalies of a window */
+/* Index[] receives the positions of the readings whose residual is more than */
+/* k robust standard deviations from the median residual, in order. The */
+/* buffers come from the arena (ANOMALY_SCRATCH_SIZE) and are released before */
+/* returning. Returns the number of anomalies, or -1 when the arena is too */
+/* small. */
+int getAnomalies(const float T[], const float EstT[], float k, struct arena *a,
+                 unsigned char Index[])
+{
+  float *residuals, *median_scratch;
+  float median, limit;
+  unsigned int mark;
+  int count, i;
+
+  mark = arenaMark(a);
+  residuals = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  median_scratch = arenaAlloc(a, ARENA_BYTES(WINDOW_LEN, float));
+  if (median_scratch == NULL)
+  {
+    arenaRelease(a, mark);
+    return -1;
+  }
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    residuals[i] = T[i] - EstT[i];
+  }
+  median = getMedian(residuals,WINDOW_LEN,median_scratch);
+
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    residuals[i] = residuals[i] > median ? residuals[i] - median : median - residuals[i];
+  }
+  limit = 1.4826f * getMedian(residuals,WINDOW_LEN,median_scratch);
+  limit = k * (limit > ANOMALY_FLOOR ? limit : ANOMALY_FLOOR);
+
+  count = 0;
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    if (residuals[i] > limit)
+      Index[count++] = i;
+  }
+
+  arenaRelease(a, mark);
+  return count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get a square root to a relative precision */
+/* getSqrt() stops at an absolute 0.001, coarser than the tracker's */
+/* variances. */
+static float getSqrtRelative(float S)
+{
+  float x = S > 1 ? S : 1;
+  int i;
+
+  if (S <= 0)
+    return 0;
+  for (i=0;i<40;i++)
+  {
+    x = 0.5f * (x + S/x);
+    if (x*x - S < S*1e-4f) // Newton comes down from above.
+      break;
+  }
+  return x;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up a tracker that knows nothing yet */
+void trackerInit(struct tracker *t)
+{
+  memset(t, 0, sizeof(*t));
+  t->P[0] = 1e4f; // offset within +-100 C.
+  t->P[2] = 100;  // slope within +-10 C per 1000 lx.
+  t->R = TRACKER_NOISE * TRACKER_NOISE;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to take one reading into the tracker */
+/* the slope is handled per 1000 lx internally, which keeps both variances */
+/* in the range of a float. Returns t->drift. */
+int trackerUpdate(struct tracker *t, float light_lx, float temp_c)
+{
+  float u = light_lx * 0.001f;
+  float slope = t->slope * 1000;
+  float Ph0, Ph1, HPH, S, k0, k1, e, limit, z, R;
+
+  // the offset may wander between readings.
+  t->P[0] += TRACKER_WANDER * TRACKER_WANDER;
+
+  Ph0 = t->P[0] + t->P[1]*u;
+  Ph1 = t->P[1] + t->P[2]*u;
+  HPH = Ph0 + Ph1*u;
+  S = HPH + t->R;
+  t->estimate = t->offset + slope*u;
+  t->sigma = getSqrtRelative(S);
+
+  // what of the squared difference the covariance does not explain is noise,
+  // averaged over all readings until there are TRACKER_SPAN of them. A glitch
+  // of more than 10 standard deviations teaches nothing. The covariance was
+  // gathered from readings weighed by the old noise, so it grows with it: a
+  // fit taken from a first reading that was a glitch is then no surer than
+  // the readings that contradict it.
+  e = temp_c - t->estimate;
+  t->count++;
+  R = t->R;
+  if (e*e < 100*S)
+    t->R += (e*e - HPH - t->R) / (t->count < TRACKER_SPAN ? t->count : TRACKER_SPAN);
+  if (t->R < TRACKER_NOISE * TRACKER_NOISE)
+    t->R = TRACKER_NOISE * TRACKER_NOISE;
+  if (t->R > R)
+  {
+    t->P[0] *= t->R / R;
+    t->P[1] *= t->R / R;
+    t->P[2] *= t->R / R;
+  }
+
+  // the CUSUM takes the difference in standard deviations of the prediction,
+  // clipped at TRACKER_CLIP.
+  z = t->sigma > 0 ? e / t->sigma : 0;
+  z = z > TRACKER_CLIP ? TRACKER_CLIP : (z < -TRACKER_CLIP ? -TRACKER_CLIP : z);
+
+  // the filter takes a difference beyond TRACKER_CLIP deviations as that many,
+  // counting the deviation of a reading once more as model error the
+  // prediction does not know of, so a wrong fit that has grown too sure of
+  // itself still comes back in a few readings. During the warm-up the fit is
+  // still forming and only what would teach the noise nothing is cut.
+  limit = getSqrtRelative(S + t->R);
+  limit *= t->count > TRACKER_WARMUP ? TRACKER_CLIP : TRACKER_WARMUP_CLIP;
+  if (limit < TRACKER_CLIP_MIN)
+    limit = TRACKER_CLIP_MIN;
+  e = e > limit ? limit : (e < -limit ? -limit : e);
+
+  k0 = Ph0 / S;
+  k1 = Ph1 / S;
+  t->offset += k0 * e;
+  t->slope = (slope + k1 * e) * 0.001f;
+  t->P[0] -= k0 * Ph0;
+  t->P[1] -= k0 * Ph1;
+  t->P[2] -= k1 * Ph1;
+
+  t->cusum[0] = t->cusum[0] + z - TRACKER_SLACK > 0 ? t->cusum[0] + z - TRACKER_SLACK : 0;
+  t->cusum[1] = t->cusum[1] - z - TRACKER_SLACK > 0 ? t->cusum[1] - z - TRACKER_SLACK : 0;
+  t->drift = 0;
+  if (t->count <= TRACKER_WARMUP)
+    t->cusum[0] = t->cusum[1] = 0;
+  else if (t->cusum[0] > TRACKER_ALARM || t->cusum[1] > TRACKER_ALARM)
+  {
+    t->drift = t->cusum[0] > TRACKER_ALARM ? 1 : -1;
+    t->alarms++;
+    t->cusum[0] = t->cusum[1] = 0;
+    // offset and slope cannot be told apart while the light holds still, so
+    // both are reopened: the offset by about 1 C, the slope by about 0.1 C
+    // per 1000 lx, and what the filter had learned of their correlation
+    // dropped. A wider slope would take most of a step at bright light.
+    t->P[0] += 1;
+    t->P[1] = 0;
+    t->P[2] += 0.01f;
+  }
+  return t->drift;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up a pipeline with empty windows */
+void pipelineInit(struct sensor_pipeline *p)
+{
+  static const float Zeros[REPORT_FREQ];
+  static const float Thresholds[ACTIVITY_LEVELS-1] = {ACTIVITY_LOW, ACTIVITY_HIGH};
+
+  memset(p, 0, sizeof(*p));
+  p->k = REPORT_FREQ;
+  classifierInit(&p->classifier, Thresholds, ACTIVITY_HYSTERESIS, ACTIVITY_MIN_DWELL);
+  p->tolerance = AGGR_TOLERANCE;
+  p->fit.method = REGRESSION;
+  trackerInit(&p->tracker);
+  statsAddBlock(&p->halves[1], Zeros, REPORT_FREQ); // the window starts with zeros.
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add one reading to the pipeline */
+/* returns the PIPELINE_ flags of the processing due after this reading. */
+int pipelineAddSample(struct sensor_pipeline *p, float light_lx, float temp_c)
+{
+  int due = 0;
+  int i;
+
+  //
+  // setup the readcount for each cycle of WINDOW_LEN readings.
+  // this will be used for the processing downstream.
+  //
+  if (p->readcount<WINDOW_LEN)
+  {
+    p->readcount++;
+  }
+  else
+  {
+    p->readcount = 1;
+  }
+
+  //
+  // logic for FIFO buffers for Light and Temperature readings.
+  //
+  for (i=0;i<WINDOW_LEN-1;i++) 
+  {
+    p->B[i] = p->B[i+1];
+    p->T[i] = p->T[i+1];
+  }
+  p->B[WINDOW_LEN-1] = light_lx;
+  p->T[WINDOW_LEN-1] = temp_c;
+  memmove(p->QB, p->QB+1, (WINDOW_LEN-1)*sizeof(short));
+  memmove(p->QT, p->QT+1, (WINDOW_LEN-1)*sizeof(short));
+  p->QB[WINDOW_LEN-1] = getSteps(light_lx, 1/LIGHT_STEP);
+  p->QT[WINDOW_LEN-1] = getSteps(temp_c, 1/TEMP_STEP);
+
+  trackerUpdate(&p->tracker, light_lx, temp_c);
+
+  if (p->readcount==p->k || p->readcount==2*p->k) // k is the frequency of measurement.
+    due |= PIPELINE_MEASURE;
+  if (p->readcount == WINDOW_LEN)
+    due |= PIPELINE_REGRESS;
+  return due;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function for activity measurement and aggregation */
+/* call when PIPELINE_MEASURE is due, so the window moved by one half since */
+/* the last call. X must hold WINDOW_LEN elements, p->AggrElementsCount of */
+/* them are set; with adaptive aggregation element i covers */
+/* p->SegmentLen[i] readings. */
+void pipelineMeasure(struct sensor_pipeline *p, float X[])
+{
+  struct stats window;
+
+  // the window is the older half of the last call and the newest readings.
+  p->halves[0] = p->halves[1];
+  statsInit(&p->halves[1]);
+  statsAddSteps(&p->halves[1], p->QB + WINDOW_LEN-REPORT_FREQ, REPORT_FREQ,
+                (float)LIGHT_STEP);
+  window = p->halves[0];
+  statsMerge(&window, &p->halves[1]);
+
+  p->StdDev = getSqrt(window.M2);
+  p->AggrElementsCount = classifierUpdate(&p->classifier, p->StdDev);
+  if (p->tolerance>0)
+    p->AggrElementsCount = segmentWindow(p->B, p->tolerance, X, p->SegmentLen);
+  else
+    aggregate(p->B, X, p->AggrElementsCount);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function for linear regression analysis */
+/* by the method in p->fit.method; returns the count of regress(), -1 when */
+/* the arena is too small. */
+int pipelineRegress(struct sensor_pipeline *p, struct arena *a)
+{
+  // least squares on the steps of the readings, unless they are too wide.
+  if (p->fit.method == REGRESS_OLS &&
+      getLeastSquaresSteps(p->QB, p->QT, &p->fit.slope, &p->fit.offset) > 0)
+  {
+    p->fit.count = WINDOW_LEN;
+    return p->fit.count;
+  }
+  return regress(p->B, p->T, p->QB, p->QT, p->fit.method, a, &p->fit);
+}
+/***********************************************************************************/
@@ -0,0 +1,428 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Sensor Data Processing                                                          */
+/*                                                                                 */
+/* The processing of sensor.c that does not depend on Contiki: window sizing,      */
+/* standard deviation, aggregation, regression and their helpers. It is built      */
+/* into the mote firmware (PROJECT_SOURCEFILES += sensor-proc.c) and into the      */
+/* host tools under tools/, so both run exactly the same code.                     */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef SENSOR_PROC_H_
+#define SENSOR_PROC_H_
+
+/***********************************************************************************/
+/* window and buffer sizing */
+/* every buffer size below is derived from these parameters; they can be */
+/* overridden from project-conf.h. */
+#ifdef SENSOR_CONF_WINDOW_LEN
+#define WINDOW_LEN SENSOR_CONF_WINDOW_LEN // readings kept in the B[] and T[] FIFOs.
+#else
+#define WINDOW_LEN 12
+#endif
+
+#define REPORT_FREQ (WINDOW_LEN/2) // k, measurement and reporting frequency.
+#define PAIR_COUNT (WINDOW_LEN*(WINDOW_LEN-1)/2) // max number of Theil-Sen slopes.
+
+#ifdef SENSOR_CONF_ARENA_BUDGET
+#define ARENA_BUDGET SENSOR_CONF_ARENA_BUDGET // bytes of RAM the arena may take.
+#else
+#define ARENA_BUDGET 2048 // of the 10 KB on Sky, leaving room for the OS and stack.
+#endif
+
+/* compile-time check, fails the build with a negative array size. */
+#define STATIC_ASSERT(cond, name) typedef char static_assert_##name[(cond) ? 1 : -1]
+
+STATIC_ASSERT(WINDOW_LEN >= 2, window_holds_a_pair);
+STATIC_ASSERT(WINDOW_LEN % 2 == 0, window_is_two_reporting_periods);
+STATIC_ASSERT(PAIR_COUNT <= 32767, pair_count_fits_int);
+STATIC_ASSERT(WINDOW_LEN % 3 == 0, window_splits_into_3_blocks);
+STATIC_ASSERT(WINDOW_LEN <= 127, segment_length_fits_a_byte);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* integer arithmetic in steps of the sensors */
+/* the readings are ADC counts scaled to lx and C, so rounded back to counts */
+/* of the sensor steps (lightFromADC() and 0.01 C, the finer of the two */
+/* temperature ADCs) they are exact small integers, and sums of their */
+/* products are exact integers too. On an MSP430 with a hardware multiplier */
+/* (MSP430F1611 on Sky) the multiply-accumulate helpers run on its MAC, */
+/* elsewhere they are plain C. Their sums are 32 bits: n * |x| * |y| must */
+/* stay below 2^31, which stepsFitMac() checks. */
+#define LIGHT_STEP (1.5*0.625e9/(4096*1e5)) // lx per light ADC step, 2.289.
+#define TEMP_STEP 0.01                      // C.
+#define STEPS_MAX 16383 // step counts saturate here, differences fit 16 bits.
+
+short getSteps(float x, float per);
+int stepsFitMac(const short X[], int n, short *lo, short *hi);
+void macSumSquares(const short X[], int n, short x0, long *sum, long *sumsq);
+long macDot(const short X[], const short Y[], int n, short x0, short y0);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* activity classifier */
+/* the window std-dev picks one of ACTIVITY_LEVELS aggregation levels: 1, 3 */
+/* or WINDOW_LEN elements per report. Above each threshold lies a hysteresis */
+/* band: the level steps up once the std-dev clears the band and steps down */
+/* once it falls below the threshold, and a std-dev inside the band keeps */
+/* the current level, so a std-dev hovering around a threshold neither flaps */
+/* between report sizes nor sends the larger one on every crossing. */
+/* Stepping down can also be held until the level has lasted */
+/* ACTIVITY_MIN_DWELL reports; stepping up is immediate, so a burst of */
+/* activity is never averaged away. A hysteresis of 0 and a dwell of 1 give */
+/* the plain threshold comparison. */
+#define ACTIVITY_LEVELS 3
+
+#ifdef SENSOR_CONF_ACTIVITY_LOW
+#define ACTIVITY_LOW SENSOR_CONF_ACTIVITY_LOW // std-dev between 1 and 3 elements.
+#else
+#define ACTIVITY_LOW 100
+#endif
+
+#ifdef SENSOR_CONF_ACTIVITY_HIGH
+#define ACTIVITY_HIGH SENSOR_CONF_ACTIVITY_HIGH // std-dev between 3 and WINDOW_LEN elements.
+#else
+#define ACTIVITY_HIGH 1000
+#endif
+
+#ifdef SENSOR_CONF_ACTIVITY_HYSTERESIS
+#define ACTIVITY_HYSTERESIS SENSOR_CONF_ACTIVITY_HYSTERESIS // band width, fraction of a threshold.
+#else
+#define ACTIVITY_HYSTERESIS 0.25
+#endif
+
+#ifdef SENSOR_CONF_ACTIVITY_MIN_DWELL
+#define ACTIVITY_MIN_DWELL SENSOR_CONF_ACTIVITY_MIN_DWELL // reports held before stepping down.
+#else
+#define ACTIVITY_MIN_DWELL 1 // holding the larger reports longer costs more than it saves.
+#endif
+
+/* what a block of readings is aggregated to. */
+#define AGGR_MEAN   0
+#define AGGR_MIN    1
+#define AGGR_MAX    2
+#define AGGR_MEDIAN 3
+
+#ifdef SENSOR_CONF_AGGR_REDUCE
+#define AGGR_REDUCE SENSOR_CONF_AGGR_REDUCE // one of the AGGR_ codes.
+#else
+#define AGGR_REDUCE AGGR_MEAN
+#endif
+
+/* adaptive aggregation: instead of equal blocks, the window is cut into as */
+/* few segments of constant value as keep every reading within */
+/* AGGR_TOLERANCE lx of its segment. 0 keeps the fixed levels of the */
+/* classifier. */
+#ifdef SENSOR_CONF_AGGR_TOLERANCE
+#define AGGR_TOLERANCE SENSOR_CONF_AGGR_TOLERANCE // lx, max error per reading.
+#else
+#define AGGR_TOLERANCE 0
+#endif
+
+struct classifier
+{
+  float up[ACTIVITY_LEVELS-1];   // std-dev at which level i steps up to i+1.
+  float down[ACTIVITY_LEVELS-1]; // std-dev below which level i+1 steps down to i.
+  int min_dwell;
+  int level;                     // current level, 0 to ACTIVITY_LEVELS-1.
+  int dwell;                     // reports classified at the current level.
+  unsigned long changes;         // level changes so far.
+};
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* scratch arena for the processing buffers */
+/* every buffer the processing needs is carved out of one statically sized */
+/* block. Persistent buffers are allocated once and kept; each processing */
+/* phase takes a mark, bump-allocates its buffers and releases back to the */
+/* mark when done, so the buffers of different phases overlap in RAM. */
+struct arena
+{
+  unsigned char *mem;
+  unsigned int size; // capacity in bytes.
+  unsigned int top;  // bytes currently allocated.
+  unsigned int peak; // high-water mark in bytes.
+};
+
+#define ARENA_ALIGN 4 // enough for float and long on MSP430 and host.
+#define ARENA_BYTES(n, type) \
+  ((((n)*sizeof(type)) + ARENA_ALIGN-1) / ARENA_ALIGN * ARENA_ALIGN)
+#define ARENA_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+void arenaInit(struct arena *a, void *mem, unsigned int size);
+void *arenaAlloc(struct arena *a, unsigned int bytes); // NULL once exhausted.
+unsigned int arenaMark(struct arena *a);
+void arenaRelease(struct arena *a, unsigned int mark);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* mergeable summary statistics */
+/* count, mean, M2 (sum of squared distances to the mean), min and max of a */
+/* set of readings. Two summaries merge in O(1) into the summary of the */
+/* union, in any order and grouping, so window statistics can be built from */
+/* those of their halves, rolled up across motes (rollup.h) and reduced in */
+/* parallel on the host. */
+struct stats
+{
+  unsigned long count;
+  float mean;
+  float M2;
+  float min;
+  float max;
+};
+
+void statsInit(struct stats *s);
+void statsAdd(struct stats *s, float x);
+void statsAddBlock(struct stats *s, const float B[], int n);
+void statsAddSteps(struct stats *s, const short Q[], int n, float step);
+void statsMerge(struct stats *s, const struct stats *other);
+float statsStdDev(const struct stats *s);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* regression of temperature on light */
+/* Temperature = offset + slope * Light over the window, by one of: */
+/*   REGRESS_OLS       least squares, O(n) and no scratch; */
+/*   REGRESS_WEIGHTED  least squares with the weight of a reading decaying */
+/*                     by REGRESS_DECAY per reading into the past, O(n); */
+/*   REGRESS_THEILSEN  median of the n(n-1)/2 pairwise slopes, robust to */
+/*                     29% outliers; */
+/*   REGRESS_SIEGEL    repeated median, the median over the readings of the */
+/*                     median slope to the others, robust to 50% outliers. */
+/* Both medians take the offset as the median of T[i] - slope * B[i]. */
+#define REGRESS_OLS      0
+#define REGRESS_WEIGHTED 1
+#define REGRESS_THEILSEN 2
+#define REGRESS_SIEGEL   3
+
+#ifdef SENSOR_CONF_REGRESSION
+#define REGRESSION SENSOR_CONF_REGRESSION // one of the REGRESS_ methods.
+#else
+#define REGRESSION REGRESS_OLS
+#endif
+
+#ifdef SENSOR_CONF_REGRESS_DECAY
+#define REGRESS_DECAY SENSOR_CONF_REGRESS_DECAY // weight of a reading against the next one.
+#else
+#define REGRESS_DECAY 0.8
+#endif
+
+struct regression
+{
+  int method;    // REGRESS_ method of the fit.
+  int count;     // readings or slopes it used, -1 when the arena was too small.
+  float slope;
+  float offset;
+};
+
+/* Theil-Sen ranks the pairwise slopes without dividing: each slope is kept */
+/* as a fraction of 16-bit sensor step counts (see LIGHT_STEP) and two */
+/* slopes are compared by cross-multiplication. Only the median is divided */
+/* out. */
+
+/* arena bytes getTheilSen() needs on top of its caller's buffers: the */
+/* numerators and denominators of the slopes, the offsets and their median */
+/* scratch. */
+#define THEILSEN_SCRATCH_SIZE (2*ARENA_BYTES(PAIR_COUNT, short) + \
+                               2*ARENA_BYTES(WINDOW_LEN, float))
+
+/* arena bytes getSiegel() needs: the slopes through one reading, the */
+/* median slope of every reading and the median scratch. */
+#define SIEGEL_SCRATCH_SIZE (3*ARENA_BYTES(WINDOW_LEN, float))
+
+/* arena bytes regress() needs for a method, and for any method. */
+#define REGRESS_SCRATCH_SIZE(method) \
+  ((method) == REGRESS_THEILSEN ? THEILSEN_SCRATCH_SIZE : \
+   (method) == REGRESS_SIEGEL ? SIEGEL_SCRATCH_SIZE : 0)
+#define REGRESS_MAX_SCRATCH_SIZE ARENA_MAX(THEILSEN_SCRATCH_SIZE, SIEGEL_SCRATCH_SIZE)
+
+#define QUANTILES_MAX 8 // max quantiles per getQuantiles() call.
+
+int d1(float f);
+unsigned int d2(float f);
+float getSqrt(float S);
+float temperatureFromADC(int tempADC);
+float lightFromADC(int lightADC);
+void printArray(char ArrName[5], float Arr[], int ArrElementsCount);
+
+float getMedian(const float TS[], int TSElementsCount, float Scratch[]);
+int getQuantiles(const float TS[], int TSElementsCount, float Scratch[],
+                 const float Q[], float Result[], int QCount);
+
+float getStdDev(const float B[]);
+void classifierInit(struct classifier *c, const float Thresholds[], float hysteresis,
+                    int min_dwell);
+int classifierUpdate(struct classifier *c, float StdDev);
+void aggregateBlocks(const float B[], float X[], int AggrElementsCount, int reduce);
+void aggregate(const float B[], float X[], int AggrElementsCount);
+int segmentWindow(const float B[], float tolerance, float X[], unsigned char Len[]);
+int getLeastSquares(const float B[], const float T[], const float W[],
+                    float *slope, float *offset);
+int getLeastSquaresSteps(const short QB[], const short QT[], float *slope,
+                         float *offset);
+int getTheilSen(const float B[], const float T[], const short QB[], const short QT[],
+                struct arena *a, float *median_slope, float *median_offset);
+int getSiegel(const float B[], const float T[], const short QB[], const short QT[],
+              struct arena *a, float *median_slope, float *median_offset);
+int regress(const float B[], const float T[], const short QB[], const short QT[],
+            int method, struct arena *a, struct regression *r);
+const char *regressName(int method);
+void getEstimate(const float B[], float median_slope, float median_offset,
+                 float EstT[]);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* anomaly detection on the regression residuals */
+/* a reading is an anomaly when its residual T[i] - EstT[i] lies more than */
+/* ANOMALY_K robust standard deviations from the median residual. The */
+/* robust standard deviation is 1.4826 times the median absolute deviation */
+/* of the residuals, so the anomalies themselves do not widen it, and at */
+/* least ANOMALY_FLOOR: readings a few steps of the sensor apart have a MAD */
+/* of 0. */
+#ifdef SENSOR_CONF_ANOMALY_K
+#define ANOMALY_K SENSOR_CONF_ANOMALY_K // robust standard deviations of an anomaly.
+#else
+#define ANOMALY_K 3.5
+#endif
+
+#ifdef SENSOR_CONF_ANOMALY_FLOOR
+#define ANOMALY_FLOOR SENSOR_CONF_ANOMALY_FLOOR // least robust std-dev, C.
+#else
+#define ANOMALY_FLOOR 0.05
+#endif
+
+/* with ANOMALY_ONLY 1 the mote prints the anomalies of every regression */
+/* and, every ANOMALY_SUMMARY regressions, a summary with the linear */
+/* equation, instead of the full vectors of every regression. The readings, */
+/* the measurements and the encoded reports are not printed either; drift */
+/* alarms and the sampling summary still are, and the reports are still sent. */
+#ifdef SENSOR_CONF_ANOMALY_ONLY
+#define ANOMALY_ONLY SENSOR_CONF_ANOMALY_ONLY // 1: anomalies and summaries only.
+#else
+#define ANOMALY_ONLY 0
+#endif
+
+#ifdef SENSOR_CONF_ANOMALY_SUMMARY
+#define ANOMALY_SUMMARY SENSOR_CONF_ANOMALY_SUMMARY // regressions per summary.
+#else
+#define ANOMALY_SUMMARY 10
+#endif
+
+/* arena bytes getAnomalies() needs: the residuals and their median scratch. */
+#define ANOMALY_SCRATCH_SIZE (2*ARENA_BYTES(WINDOW_LEN, float))
+
+int getAnomalies(const float T[], const float EstT[], float k, struct arena *a,
+                 unsigned char Index[]);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* online temperature tracker */
+/* a Kalman filter over offset and slope of Temperature = offset + slope * */
+/* Light, updated with every reading in constant time. Before taking a */
+/* reading's temperature it predicts it from the light, with the standard */
+/* deviation of that prediction; the noise of the readings themselves is */
+/* learned as they come, TRACKER_NOISE being its floor, and the covariance */
+/* grows with it. The difference is clipped at TRACKER_CLIP times the */
+/* deviation of the prediction and of a reading together (TRACKER_CLIP_MIN at */
+/* least, TRACKER_WARMUP_CLIP times while the fit forms), so a glitch of the */
+/* sensor moves the fit by a fraction of a degree; it feeds the filter and a */
+/* two-sided CUSUM. A run of differences of one sign raises a drift alarm */
+/* within a few readings, where a window fit would only move at its next */
+/* regression; the alarm reopens the offset and slope variances so the filter */
+/* follows the new level. */
+#ifdef SENSOR_CONF_TRACKER_NOISE
+#define TRACKER_NOISE SENSOR_CONF_TRACKER_NOISE // std-dev of a temperature reading, C.
+#else
+#define TRACKER_NOISE 0.05
+#endif
+
+#ifdef SENSOR_CONF_TRACKER_SPAN
+#define TRACKER_SPAN SENSOR_CONF_TRACKER_SPAN // readings over which the noise is learned.
+#else
+#define TRACKER_SPAN 64
+#endif
+
+#ifdef SENSOR_CONF_TRACKER_WANDER
+#define TRACKER_WANDER SENSOR_CONF_TRACKER_WANDER // offset random walk per reading, C.
+#else
+#define TRACKER_WANDER 0.001
+#endif
+
+#ifdef SENSOR_CONF_TRACKER_ALARM
+#define TRACKER_ALARM SENSOR_CONF_TRACKER_ALARM // CUSUM level of a drift alarm.
+#else
+#define TRACKER_ALARM 8
+#endif
+
+#define TRACKER_CLIP 3          // standardized differences are clipped to +-3.
+#define TRACKER_CLIP_MIN 0.25   // C, the clip never comes closer than this.
+#define TRACKER_WARMUP_CLIP 10  // the clip during the warm-up.
+#define TRACKER_SLACK 0.5       // CUSUM allowance per reading, in standard deviations.
+#define TRACKER_WARMUP WINDOW_LEN // readings before the first alarm.
+
+struct tracker
+{
+  float offset;         // C.
+  float slope;          // C per lx.
+  float P[3];           // covariance of offset and slope per 1000 lx: 00, 01, 11.
+  float R;              // variance of a reading, C^2.
+  unsigned long count;  // readings taken.
+
+  // prediction for the last reading, before its temperature was taken.
+  float estimate;       // C.
+  float sigma;          // its standard deviation, C.
+
+  float cusum[2];       // of the standardized differences, upwards and downwards.
+  int drift;            // +1 or -1 when the last reading raised an alarm, else 0.
+  unsigned long alarms; // drift alarms so far.
+};
+
+void trackerInit(struct tracker *t);
+int trackerUpdate(struct tracker *t, float light_lx, float temp_c);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* processing pipeline state */
+/* everything one sensor_reading_process loop keeps between readings. The */
+/* pipeline functions only touch the struct they are given and scratch from */
+/* the arena they are given, so any number of pipelines can run side by */
+/* side (several channels on one mote, thousands on the host) and share one */
+/* scratch arena as long as they are processed one at a time. */
+struct sensor_pipeline
+{
+  float B[WINDOW_LEN];   // this is the buffer to save light readings.
+  float T[WINDOW_LEN];   // this is the buffer to save temperature readings.
+  short QB[WINDOW_LEN];  // the same readings in steps of the sensors.
+  short QT[WINDOW_LEN];
+  int readcount;         // varied from 1 to WINDOW_LEN, then reset to 1.
+  int k;                 // this is the frequency of measurement and reporting.
+
+  // statistics of the older and the newer half of the window, advanced by
+  // pipelineMeasure().
+  struct stats halves[2];
+
+  struct classifier classifier; // aggregation level of the reports.
+  float tolerance;       // of adaptive aggregation in lx, 0 for the fixed levels.
+
+  // results of the last pipelineMeasure().
+  float StdDev;
+  int AggrElementsCount; // this is the count of aggregated elements - 1, 3, or WINDOW_LEN.
+  unsigned char SegmentLen[WINDOW_LEN]; // readings per element, adaptive aggregation only.
+
+  // result of the last pipelineRegress(), fit by the method set in fit.method.
+  struct regression fit;
+
+  struct tracker tracker; // updated with every reading.
+};
+
+/* flags returned by pipelineAddSample(), the processing due for the reading. */
+#define PIPELINE_MEASURE 0x01 // activity measurement, aggregation and reporting.
+#define PIPELINE_REGRESS 0x02 // linear regression analysis.
+
+void pipelineInit(struct sensor_pipeline *p);
+int pipelineAddSample(struct sensor_pipeline *p, float light_lx, float temp_c);
+void pipelineMeasure(struct sensor_pipeline *p, float X[]);
+int pipelineRegress(struct sensor_pipeline *p, struct arena *a);
+/***********************************************************************************/
+
+#endif /* SENSOR_PROC_H_ */
@@ -11,331 +11,497 @@
 /* - Aggregation and Reporting                                                     */
 /* - Advanced Feature: Linear Regression Analysis                                  */
 /*                                                                                 */
+/* The processing itself lives in sensor-proc.c, the report encoding in            */
+/* report-codec.c, the packet batching in transport.c and the summaries in         */
+/* rollup.c, all shared with the host tools, and the double-buffered sampling in   */
+/* acquire.c; build with PROJECT_SOURCEFILES += sensor-proc.c report-codec.c       */
+/* transport.c rollup.c acquire.c. The sensors are read by a process of their own, */
+/* the processing takes the readings a block at a time in another one.             */
+/* The reports go to the sink node (sink.c) by Rime unicast; built with            */
+/* SENSOR_CONF_ROLLUP 1, summaries go to the parent relay node (relay.c) instead.  */
+/*                                                                                 */
 /***********************************************************************************/
 #include "contiki.h"
 #include "dev/light-sensor.h"
 #include "dev/sht11-sensor.h"
+#include "dev/watchdog.h"
+#include "net/rime/rime.h"
+#include "sensor-proc.h"
+#include "report-codec.h"
+#include "transport.h"
+#include "rollup.h"
+#include "acquire.h"
 #include <stdio.h> // for printf(). 
 
 /***********************************************************************************/
-/* function to get the integer part of a floating point number */
-int d1(float f) // integer part.
+/* function to get temperature reading from sensor */
+float getTemperature(void)
 {
-  return((int)f);
+  // for simulation sky mote.
+  return temperatureFromADC(sht11_sensor.value(SHT11_SENSOR_TEMP_SKYSIM));
+
+  // for XM1000 mote, see temperatureFromADC().
+  //return temperatureFromADC(sht11_sensor.value(SHT11_SENSOR_TEMP));
 }
 /***********************************************************************************/
 
 /***********************************************************************************/
-/* function to get the fractional part of a floating point number */
-/* upto 3 positions */
-unsigned int d2(float f) // fractional part.
+/* function to get light intensity reading from sensor */
+float getLight(void)
 {
-  if (f>0)
-    return(1000*(f-d1(f)));
+  return lightFromADC(light_sensor.value(LIGHT_SENSOR_PHOTOSYNTHETIC));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to print the output of activity measurement, aggregation (reporting) */
+void printMeasurement(struct sensor_pipeline *p, float X[])
+{
+  int i;
+
+  printf("\nMeasurement and Reporting (Frequency = After every %d Sensor Data Reads)",
+         p->k);
+
+  printArray("B", p->B, WINDOW_LEN);
+
+  printf("StdDev = %d.%03u\n", d1(p->StdDev), d2(p->StdDev));
+  
+  if (p->tolerance>0)
+  {
+    printf("Aggregation = Adaptive, Segment Lengths =");
+    for (i=0;i<p->AggrElementsCount;i++)
+      printf(" %d", p->SegmentLen[i]);
+  }
+  else if (p->AggrElementsCount==WINDOW_LEN)
+    printf("Aggregation = 1-into-1 (No Aggregation)");
   else
-    return(1000*(d1(f)-f));
+    printf("Aggregation = %d-into-1", WINDOW_LEN/p->AggrElementsCount);
+  
+  printArray("X", X, p->AggrElementsCount);
+  printf("\n");    
 }
 /***********************************************************************************/
 
 /***********************************************************************************/
-/* function to get temperature reading from sensor */
-float getTemperature(void)
+/* function to print an encoded report as hex, for tools/codec.c -d */
+void printEncoded(unsigned char Enc[], int EncLen)
 {
-  // for simulation sky mote.
-  int tempADC = sht11_sensor.value(SHT11_SENSOR_TEMP_SKYSIM);
-  float temp_c = 0.04*tempADC-39.6; //skymote uses 12-bit ADC, or 0.04 resolution.
+  int i;
 
-  // for XM1000 mote.
-  //int tempADC = sht11_sensor.value(SHT11_SENSOR_TEMP);
-  //float temp_c = 0.01*tempADC-39.6; // xm1000 uses 14-bit ADC, or 0.01 resolution.
+  printf("Encoded X = ");
+  for (i=0;i<EncLen;i++)
+  {
+    printf("%02x", Enc[i]);
+  }
+  printf(" (%d bytes)\n", EncLen);
+}
+/***********************************************************************************/
 
-  return temp_c;
+/***********************************************************************************/
+/* function to encode a report by the aggregation of the pipeline */
+static int encodeReport(struct report_codec *c, struct sensor_pipeline *p, float X[],
+                        unsigned char Enc[])
+{
+  if (p->tolerance>0)
+    return codecEncodeSegments(c, X, p->SegmentLen, p->AggrElementsCount, Enc);
+  else
+    return codecEncode(c, X, p->AggrElementsCount, Enc);
 }
 /***********************************************************************************/
 
 /***********************************************************************************/
-/* function to get light intensity reading from sensor */
-float getLight(void)
+/* function to tell whether a fit differs from the last one printed */
+/* by more than SUPPRESS_SLOPE or SUPPRESS_OFFSET; last->count is 0 before */
+/* the first. */
+static int fitChanged(const struct regression *last, const struct regression *fit)
 {
-  float V_sensor = 1.5 * light_sensor.value(LIGHT_SENSOR_PHOTOSYNTHETIC)/4096;
-                                     // ADC-12 uses 1.5V_REF.
-  float I = V_sensor/100000;         // xm1000 uses 100kohm resistor.
-  float light_lx = 0.625*1e6*I*1000; // convert from current to light intensity.
+  float ds = fit->slope - last->slope, doff = fit->offset - last->offset;
 
-  return light_lx;
+  return last->count == 0 || fit->method != last->method ||
+         ds > SUPPRESS_SLOPE || ds < -SUPPRESS_SLOPE ||
+         doff > SUPPRESS_OFFSET || doff < -SUPPRESS_OFFSET;
 }
 /***********************************************************************************/
 
 /***********************************************************************************/
-/* function to find the square root */
-float sqrt(float S)
+/* function to print the output of linear regression analysis */
+void printRegression(struct sensor_pipeline *p, float EstT[])
 {
-  float difference = 0.0;
-  float error = 0.001;  // error tolerance.
-  float x = 10.0;       // initial guess.
-  int i;
-  for (i=0; i<50; i++)  // looping 50 times.
+  printf("Linear Regression Analysis by %s Method", regressName(p->fit.method));
+  printf(" (Frequency = After every %d Sensor Data Reads)\n", 2*p->k);
+  printf("Assumption: Temperature is dependent on Light\n");
+  printf("Light Vector (Independent Vector) B: "); 
+  printArray("B", p->B, WINDOW_LEN);
+  printf("Temperature Vector (Dependent Vector) T: ");
+  printArray("T", p->T, WINDOW_LEN);
+  printf("Slope: %d.%03u\n", d1(p->fit.slope), d2(p->fit.slope));
+  printf("Offset: %d.%03u\n", d1(p->fit.offset), d2(p->fit.offset));
+  printf("Linear Equation: Temperature = %d.%03u + %d.%03u * Light\n", 
+         d1(p->fit.offset), d2(p->fit.offset), d1(p->fit.slope), d2(p->fit.slope));
+  printf("Estimated Temperature Vector EstT:");
+  printArray("EstT", EstT, WINDOW_LEN);
+  printf("\n");
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to print the anomalies found in the regression window */
+void printAnomalies(struct sensor_pipeline *p, float EstT[], unsigned char Index[],
+                    int AnomaliesCount)
+{
+  int i, j;
+
+  for (j=0;j<AnomaliesCount;j++)
   {
-    x = 0.5 * (x + S/x);
-    difference = x*x - S;
-    if (difference<0) difference = -difference;
-    if (difference<error) break; // the difference is deemed small enough.
+    i = Index[j];
+    printf("Anomaly: Temp %d.%03u C at %d.%03u lx, estimated %d.%03u C\n",
+           d1(p->T[i]), d2(p->T[i]), d1(p->B[i]), d2(p->B[i]), d1(EstT[i]), d2(EstT[i]));
   }
-  return x;
 }
 /***********************************************************************************/
 
 /***********************************************************************************/
-/* function to print the elements of an array */
-void printArray(char ArrName[5], float Arr[12], int ArrElementsCount)
+/* function to print the summary of the regressions since the last one */
+/* the anomalies-only replacement of printRegression(). */
+void printRegressionSummary(struct sensor_pipeline *p, int RegressionsCount,
+                            int AnomaliesCount)
 {
-  int i;
-  printf("\n%s = [", ArrName);
-  for (i=0;i<ArrElementsCount;i++)
+  printf("Linear Regression Summary by %s Method", regressName(p->fit.method));
+  printf(" (%d Regressions, %d Anomalies)\n", RegressionsCount, AnomaliesCount);
+  printf("Slope: %d.%03u\n", d1(p->fit.slope), d2(p->fit.slope));
+  printf("Offset: %d.%03u\n", d1(p->fit.offset), d2(p->fit.offset));
+  printf("\n");
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* radio link to the sink */
+static struct unicast_conn uc;
+static const struct unicast_callbacks unicast_callbacks = {NULL}; // reports are only sent.
+
+/* function to send one packet of reports to the sink, called by transport.c */
+static void sendPacket(const unsigned char *buf, int len, void *ctx)
+{
+  linkaddr_t sink;
+
+  sink.u8[0] = SINK_ADDR0;
+  sink.u8[1] = SINK_ADDR1;
+  packetbuf_copyfrom(buf, len);
+  unicast_send(&uc, &sink);
+}
+/***********************************************************************************/
+
+#if ROLLUP
+STATIC_ASSERT(ROLLUP_MAX_BYTES <= PACKETBUF_SIZE, summary_fits_packetbuf);
+
+/***********************************************************************************/
+/* function to send the summary of the readings since the last report to the */
+/* parent relay node */
+static void sendSummary(struct sensor_pipeline *p, struct rollup *r, unsigned char buf[])
+{
+  linkaddr_t parent;
+  int len;
+
+  rollupInit(r);
+  rollupAddWindow(r, p->B + WINDOW_LEN-REPORT_FREQ, REPORT_FREQ);
+  len = rollupPack(r, buf);
+
+  parent.u8[0] = ROLLUP_PARENT0;
+  parent.u8[1] = ROLLUP_PARENT1;
+  packetbuf_copyfrom(buf, len);
+  unicast_send(&uc, &parent);
+}
+/***********************************************************************************/
+#endif
+
+/***********************************************************************************/
+/* scratch arena layout for sensor_reading_process */
+/* the peak usage is fixed at build time: the larger of the two processing */
+/* phases; in the measurement phase the suppression probe is released before */
+/* the summary is allocated, so only the larger of the two counts. */
+/* sensor_arena_mem is sized to exactly that, so its size in the symbol table */
+/* (e.g. msp430-nm -S sensor.sky) is the peak arena usage of the build. The */
+/* arena is shared by all pipelines of the mote. */
+#if ROLLUP
+#define ARENA_SUMMARY_SIZE (ARENA_BYTES(1, struct rollup) + \
+                            ARENA_BYTES(ROLLUP_MAX_BYTES, unsigned char))
+#else
+#define ARENA_SUMMARY_SIZE 0
+#endif
+#if SUPPRESS
+#define ARENA_SUPPRESS_SIZE ARENA_BYTES(1, struct report_codec) // encoder probe.
+#else
+#define ARENA_SUPPRESS_SIZE 0
+#endif
+#define ARENA_AGGREGATION_SIZE (ARENA_BYTES(WINDOW_LEN, float) + /* X[] */ \
+                                ARENA_BYTES(CODEC_MAX_BYTES, unsigned char) + \
+                                ARENA_MAX(ARENA_SUMMARY_SIZE, ARENA_SUPPRESS_SIZE))
+#define ARENA_REGRESSION_SIZE (ARENA_BYTES(WINDOW_LEN, float) + /* EstT[] */ \
+                               ARENA_BYTES(WINDOW_LEN, unsigned char) + /* Anomaly[] */ \
+                               ARENA_MAX(REGRESS_SCRATCH_SIZE(REGRESSION), \
+                                         ANOMALY_SCRATCH_SIZE))
+#define ARENA_SIZE (ARENA_MAX(ARENA_AGGREGATION_SIZE, ARENA_REGRESSION_SIZE))
+
+STATIC_ASSERT(ARENA_SIZE <= ARENA_BUDGET, arena_fits_ram_budget);
+
+static long sensor_arena_mem[(ARENA_SIZE + sizeof(long)-1) / sizeof(long)];
+static struct arena sensor_arena;
+
+/* function to take scratch memory from the arena of the mote */
+/* the layout above sizes the arena for every phase, so running out is a bug */
+/* in that layout: it is reported and the mote restarted, rather than */
+/* writing through a NULL pointer. */
+static void *sensorAlloc(unsigned int bytes)
+{
+  void *p = arenaAlloc(&sensor_arena, bytes);
+
+  if (p == NULL)
   {
-    printf("%d.%03u", d1(Arr[i]), d2(Arr[i]));
-    if (i<(ArrElementsCount-1))
-    {
-      printf (", ");
-    }
+    printf("Arena exhausted: %u bytes more of %u\n", bytes, (unsigned int)ARENA_SIZE);
+    watchdog_reboot();
   }
-  printf("]\n");
+  return p;
 }
 /***********************************************************************************/
 
 /***********************************************************************************/
-/* function to find the median */
-float getMedian(float TS[144], int TSElementsCount)
+/* function to print the timing of the sampling since the last summary */
+void printSampling(struct acquire *a)
 {
-  float intermed;
-  float median;
-  int i, j;
-  
-  // first sort the array.
-  for (i=0;i<TSElementsCount-1;i++) 
+  const struct stats *s = &a->spacing;
+  float mean = s->mean * 1000 / RTIMER_SECOND, std = statsStdDev(s) * 1000 / RTIMER_SECOND;
+  float min = s->min * 1000 / RTIMER_SECOND, max = s->max * 1000 / RTIMER_SECOND;
+  float edge = (float)ACQUIRE_JITTER_STEP * 1000 / RTIMER_SECOND;
+  int b;
+
+  printf("Sampling: %lu intervals, spacing %d.%03u ms +- %d.%03u ms, ", s->count,
+         d1(mean), d2(mean), d1(std), d2(std));
+  printf("min %d.%03u ms, max %d.%03u ms, %lu overruns, %lu missed\n", d1(min), d2(min),
+         d1(max), d2(max), a->overruns, a->missed);
+
+  printf("Jitter:");
+  for (b=0;b<ACQUIRE_JITTER_BINS-1;b++, edge*=2)
   {
-    for (j=i+1;j<=TSElementsCount-1;j++)
-    {
-      if (TS[i] > TS[j]) 
-      {
-        intermed = TS[i];
-        TS[i] = TS[j];
-        TS[j] = intermed;
-      }
-    }
+    if (a->jitter[b] > 0)
+      printf(" <%d.%03u ms %lu,", d1(edge), d2(edge), a->jitter[b]);
   }
+  printf(" more %lu\n", a->jitter[ACQUIRE_JITTER_BINS-1]);
+}
+/***********************************************************************************/
 
-  // find median value from the sorted array.
-  if (TSElementsCount % 2 == 0)
-    median = (TS[(TSElementsCount/2)-1] + TS[(TSElementsCount/2)])/2;
-  else
-    median = TS[(int)(TSElementsCount/2)];
+#define SAMPLE_PERIOD (CLOCK_CONF_SECOND/2) // 2 readings per second.
 
-  return median;
-}
-/***********************************************************************************/ 
+static struct acquire acquire; // readings passed from sampling to processing.
 
 /*---------------------------------------------------------------------------*/
+PROCESS(sensor_acquire_process, "Sensor acquisition process");
 PROCESS(sensor_reading_process, "Sensor reading process");
-AUTOSTART_PROCESSES(&sensor_reading_process);
+AUTOSTART_PROCESSES(&sensor_acquire_process, &sensor_reading_process);
 /*---------------------------------------------------------------------------*/
-PROCESS_THREAD(sensor_reading_process, ev, data)
+PROCESS_THREAD(sensor_acquire_process, ev, data)
 {
   static struct etimer timer;
-
-  static int readcount = 0; // varied from 1 to 12, once reaches 12 this will be reset to 1.
-  static float B[12] = {0}; // this is the buffer to save light readings.
-  static float T[12] = {0}; // this is the buffer to save temperature readings.
-  
-  static int k = 6; // this is the frequency of measurement and reporting.
-
-  // below variables are for calculating standard deviation.
-  static float Sum, Mean, SumofDistSquares, StdDev; 
-
-  // below variables are for aggregation.
-  static int AggrElementsCount; // this is the count of aggregated elements - 1, 3, or 12.
-  static float X[12]; // this is the array for aggregated elements, declared with max 12.
-
-  // below variables are for linear regression analysis.
-  static float slopes[144] = {0};
-  static int slopes_count;
-  static float median_slope;
-  static float offsets[12] = {0};
-  static float median_offset;
-  static float EstT[12]; // this is the estimated temperature vector.
-                         
-  static int i,j;
+  static clock_time_t next; // instant of the next reading, on the grid of SAMPLE_PERIOD.
+  clock_time_t now;
 
   PROCESS_BEGIN();
-  etimer_set(&timer, CLOCK_CONF_SECOND/2); // timer setting to trigger 2 events per second.
-                                           
+  acquireInit(&acquire, RTIMER_SECOND/2);
+
   SENSORS_ACTIVATE(light_sensor);
   SENSORS_ACTIVATE(sht11_sensor);
 
+  next = clock_time() + SAMPLE_PERIOD;
+  etimer_set(&timer, SAMPLE_PERIOD);
+
   while(1)
   {
-    PROCESS_WAIT_EVENT_UNTIL(ev=PROCESS_EVENT_TIMER);
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER && data == &timer);
 
+    rtimer_clock_t stamp = RTIMER_NOW(); // before the SHT11, which takes its time.
     float temp_c = getTemperature();
     float light_lx = getLight();
-    
-    //
-    // setup the readcount for each cycle of 12 readings.
-    // this will be used for the processing downstream.
-    //
-    if (readcount<12)
-    {
-      readcount++;
-    }
-    else
-    {
-      readcount = 1;
-    }
-    
+
+    if (acquireAdd(&acquire, light_lx, temp_c, stamp))
+      process_poll(&sensor_reading_process);
+
     //
-    // logic for FIFO buffers for Light and Temperature readings.
+    // the next instant is a whole number of periods from the first, never from
+    // when this reading was taken. instants already past are skipped, not read
+    // late in a burst as etimer_reset() would.
     //
-    for (i=0;i<11;i++) 
+    now = clock_time(); // read once, a tick between two reads would wrap the interval.
+    next += SAMPLE_PERIOD;
+    while (CLOCK_LT(next, now))
     {
-      B[i] = B[i+1];
-      T[i] = T[i+1];
+      next += SAMPLE_PERIOD;
+      acquire.missed++;
     }
-    B[11] = light_lx;
-    T[11] = temp_c;
-    printf("Light: %d.%03u lx, ", d1(light_lx), d2(light_lx));
-    printf("Temp: %d.%03u C\n", d1(temp_c), d2(temp_c));
+    etimer_set(&timer, next - now);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(sensor_reading_process, ev, data)
+{
+  static int block, i; // block of readings being processed, reading in it.
 
-    //
-    // logic for activity measurement, aggregation and reporting.
-    //
-    if (readcount==k || readcount==2*k) // k is the frequency of measurement.
+  static struct sensor_pipeline pipeline; // windows, readcount and results.
+  static int due; // PIPELINE_ flags of the processing due for this reading.
+
+  static struct report_codec codec; // previous report, the reference of the next one.
+  static struct transport transport; // packet of reports waiting to be sent.
+
+  static float *X; // this is the array for aggregated elements, allocated with max WINDOW_LEN.
+  static unsigned char *Enc; // this is the encoded report.
+  static int EncLen;
+  static float *EstT; // this is the estimated temperature vector.
+  static unsigned char *Anomaly; // positions of the anomalies in the window.
+  static int AnomaliesCount;
+  static int regressions, anomalies; // since the last regression summary.
+  static struct report_codec *probe; // copy of codec, for the size of a suppressed report.
+  static struct regression last_fit; // the last fit printed in full.
+  static unsigned long suppressed, suppressed_bytes; // reports sent as heartbeats.
+  static unsigned long suppressed_fits;
+  static unsigned int mark; // arena position to release back to after each phase.
+  static unsigned int probe_mark; // and after the probe, within the measurement phase.
+
+  PROCESS_EXITHANDLER(unicast_close(&uc);)
+
+  PROCESS_BEGIN();
+  arenaInit(&sensor_arena, sensor_arena_mem, sizeof(sensor_arena_mem));
+  pipelineInit(&pipeline);
+  codecInit(&codec);
+  unicast_open(&uc, ROLLUP ? ROLLUP_CHANNEL : TRANSPORT_CHANNEL, &unicast_callbacks);
+  transportInit(&transport, TRANSPORT_BATCH, sendPacket, NULL);
+
+  while(1)
+  {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    block = acquireBlock(&acquire);
+    if (block < 0)
+      continue; // a poll with no complete block, e.g. one posted by another process.
+
+    for (i=0;i<ACQUIRE_BLOCK;i++)
     {
-      // calculate standard deviation.
-      Sum = 0;
-      for (i=0;i<12;i++)
+      float temp_c = acquire.temp[block][i];
+      float light_lx = acquire.light[block][i];
+
+      due = pipelineAddSample(&pipeline, light_lx, temp_c);
+      if (!ANOMALY_ONLY)
       {
-        Sum = Sum + B[i];
+        printf("Light: %d.%03u lx, ", d1(light_lx), d2(light_lx));
+        printf("Temp: %d.%03u C\n", d1(temp_c), d2(temp_c));
       }
-      Mean = Sum/12;
-      
-      SumofDistSquares = 0;
-      for (i=0;i<12;i++)
+      if (pipeline.tracker.drift != 0)
       {
-        SumofDistSquares = SumofDistSquares + ((B[i]-Mean)*(B[i]-Mean));
+        printf("Drift: Temp %s the estimate of %d.%03u C +- %d.%03u C\n",
+               pipeline.tracker.drift > 0 ? "above" : "below",
+               d1(pipeline.tracker.estimate), d2(pipeline.tracker.estimate),
+               d1(pipeline.tracker.sigma), d2(pipeline.tracker.sigma));
       }
-      StdDev = sqrt(SumofDistSquares);
 
-      // logic for aggregation. 
-      if (StdDev<100)
+      //
+      // logic for activity measurement, aggregation and reporting.
+      //
+      if (due & PIPELINE_MEASURE)
       {
-        AggrElementsCount = 1;
-      }
-      else
-      {
-        if (StdDev<1000)
+        mark = arenaMark(&sensor_arena);
+        X = sensorAlloc(ARENA_BYTES(WINDOW_LEN, float));
+        Enc = sensorAlloc(ARENA_BYTES(CODEC_MAX_BYTES, unsigned char));
+
+        pipelineMeasure(&pipeline, X);
+
+        if (SUPPRESS && !codecChanged(&codec, X, pipeline.tolerance>0 ? pipeline.SegmentLen
+                                      : NULL, pipeline.AggrElementsCount, SUPPRESS_LIGHT))
         {
-          AggrElementsCount = 3;
+          // what the report would have cost, encoded by a copy of the codec,
+          // released before the summary below is allocated.
+          probe_mark = arenaMark(&sensor_arena);
+          probe = sensorAlloc(ARENA_BYTES(1, struct report_codec));
+          *probe = codec;
+          EncLen = encodeReport(probe, &pipeline, X, Enc);
+          arenaRelease(&sensor_arena, probe_mark);
+          suppressed++;
+          suppressed_bytes += EncLen;
+
+          EncLen = codecEncodeHeartbeat(&codec, Enc);
+          suppressed_bytes -= EncLen;
+          if (!ANOMALY_ONLY)
+            printf("\nHeartbeat: Measurement unchanged (%lu suppressed, %lu bytes saved)\n",
+                   suppressed, suppressed_bytes);
         }
         else
         {
-          AggrElementsCount = 12;
+          if (!ANOMALY_ONLY)
+            printMeasurement(&pipeline, X);
+          EncLen = encodeReport(&codec, &pipeline, X, Enc);
         }
-      }
+        // the report still goes out by radio, only its serial copy is left out.
+        if (!ANOMALY_ONLY)
+          printEncoded(Enc, EncLen);
+#if ROLLUP
+        sendSummary(&pipeline, sensorAlloc(ARENA_BYTES(1, struct rollup)),
+                    sensorAlloc(ARENA_BYTES(ROLLUP_MAX_BYTES, unsigned char)));
+#else
+        transportAddReport(&transport, Enc, EncLen);
+#endif
 
-      if (AggrElementsCount==1)
-      {
-        X[0] = (B[0]+B[1]+B[2]+B[3]+B[4]+B[5]+B[6]+B[7]+B[8]+B[9]+B[10]+B[11])/12;
+        arenaRelease(&sensor_arena, mark);
       }
-      if (AggrElementsCount==3)
-      {
-        X[0] = (B[0]+B[1]+B[2]+B[3])/4;
-        X[1] = (B[4]+B[5]+B[6]+B[7])/4;
-        X[2] = (B[8]+B[9]+B[10]+B[11])/4;
-      }
-      if (AggrElementsCount==12)
+    
+      //
+      // logic for linear regression analysis.
+      //
+      if (due & PIPELINE_REGRESS)
       {
-        for (i=0;i<12;i++)
-        { 
-          X[i] = B[i];
-        }
-      }
-      
-      // print the output of activity measurement, aggregation (reporting).
-      printf("\nMeasurement and Reporting (Frequency = After every %d Sensor Data Reads)",
-             k);
+        PROCESS_PAUSE(); // between the report and the fit, both due at readcount 12.
 
-      printArray("B", B, 12);
+        mark = arenaMark(&sensor_arena);
+        EstT = sensorAlloc(ARENA_BYTES(WINDOW_LEN, float));
+        Anomaly = sensorAlloc(ARENA_BYTES(WINDOW_LEN, unsigned char));
 
-      printf("StdDev = %d.%03u\n", d1(StdDev), d2(StdDev));
-      
-      switch (AggrElementsCount)
-      {
-        case 1:
-          printf("Aggregation = 12-into-1");
-          break;
-
-        case 3:
-          printf("Aggregation = 4-into-1");
-          break;
-        case 12:
-          printf("Aggregation = 1-into-1 (No Aggregation)");
-          break;
-      }
-      
-      printArray("X", X, AggrElementsCount);
-      printf("\n");    
-    }
-    
-    //
-    // logic for linear regression analysis.
-    //
-    if (readcount == 12)
-    {
-      slopes_count = 0;
-      for (i=0;i<12;i++) 
-      {
-        for (j=i+1;j<12;j++) 
+        pipelineRegress(&pipeline, &sensor_arena);
+
+        // derive the estimated temperature vector, 
+        // values are calculated using the linear equation.
+        getEstimate(pipeline.B, pipeline.fit.slope, pipeline.fit.offset, EstT);
+
+        AnomaliesCount = getAnomalies(pipeline.T, EstT, ANOMALY_K, &sensor_arena, Anomaly);
+        regressions++;
+        anomalies += AnomaliesCount;
+
+        if (!ANOMALY_ONLY)
         {
-          if (B[i] != B[j])
+          if (SUPPRESS && !fitChanged(&last_fit, &pipeline.fit))
+          {
+            suppressed_fits++;
+            printf("Heartbeat: Regression unchanged (%lu suppressed)\n\n", suppressed_fits);
+          }
+          else
           {
-            slopes[slopes_count++] = (T[j] - T[i]) / (B[j] - B[i]);
+            printRegression(&pipeline, EstT);
+            last_fit = pipeline.fit;
           }
         }
-      }
-      median_slope = getMedian(slopes,slopes_count);
+        printAnomalies(&pipeline, EstT, Anomaly, AnomaliesCount);
+        if (ANOMALY_ONLY && regressions == ANOMALY_SUMMARY)
+        {
+          printRegressionSummary(&pipeline, regressions, anomalies);
+          regressions = anomalies = 0;
+        }
 
-      for (i=0;i<12;i++) 
-      {
-        offsets[i] = T[i] - median_slope * B[i];
+        arenaRelease(&sensor_arena, mark);
       }
-      median_offset = getMedian(offsets,12); 
-      
-      // derive the estimated temperature vector, 
-      // values are calculated using the linear equation.
-      for (i=0;i<12;i++)
-      {
-        EstT[i] = median_slope * B[i] + median_offset;
-      }     
-
-      // print the output of linear regression analysis.
-      printf("Linear Regression Analysis by Theil-Sen Estimator Method");
-      printf(" (Frequency = After every %d Sensor Data Reads)\n", 2*k);
-      printf("Assumption: Temperature is dependent on Light\n");
-      printf("Light Vector (Independent Vector) B: "); 
-      printArray("B", B, 12);
-      printf("Temperature Vector (Dependent Vector) T: ");
-      printArray("T", T, 12);
-      printf("Median Slope: %d.%03u\n", d1(median_slope), d2(median_slope));
-      printf("Median Offset: %d.%03u\n", d1(median_offset), d2(median_offset));
-      printf("Linear Equation: Temperature = %d.%03u + %d.%03u * Light\n", 
-             d1(median_offset), d2(median_offset), d1(median_slope), d2(median_slope));
-      printf("Estimated Temperature Vector EstT:");
-      printArray("EstT", EstT, 12);
-      printf("\n");
+
+      PROCESS_PAUSE(); // lets the sampling take the next reading in time.
+    }
+    acquireRelease(&acquire);
+
+    if (acquire.spacing.count >= ACQUIRE_REPORT)
+    {
+      printSampling(&acquire);
+      acquireClear(&acquire);
     }
- 
-    etimer_reset(&timer);
-    
   }
   PROCESS_END();
 }
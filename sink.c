@@ -0,0 +1,76 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Report Sink                                                                     */
+/*                                                                                 */
+/* Receives the report packets of the sensor motes (sensor.c) by Rime unicast,     */
+/* decodes them and prints one line per report on the serial port of the sink:     */
+/*                                                                                 */
+/*   Report from 2.0: X = [917.400]                                                */
+/*                                                                                 */
+/* Give the sink the Rime address SINK_ADDR0.SINK_ADDR1 of transport.h (node id 1  */
+/* in Cooja). Build with PROJECT_SOURCEFILES += sensor-proc.c report-codec.c       */
+/* transport.c.                                                                    */
+/*                                                                                 */
+/***********************************************************************************/
+#include "contiki.h"
+#include "net/rime/rime.h"
+#include "sensor-proc.h"
+#include "transport.h"
+#include <stdio.h> // for printf().
+
+static struct unicast_conn uc;
+static struct transport_sink sink; // decoder state of every sender.
+
+/***********************************************************************************/
+/* function to print one decoded report, called by transport.c */
+static void printReport(unsigned int id, const long X[], int AggrElementsCount, void *ctx)
+{
+  float x;
+  int i;
+
+  printf("Report from %u.%u: X = [", id >> 8, id & 0xff);
+  for (i=0;i<AggrElementsCount;i++)
+  {
+    x = (float)X[i] / CODEC_SCALE;
+    printf("%d.%03u", d1(x), d2(x));
+    if (i<(AggrElementsCount-1))
+    {
+      printf(", ");
+    }
+  }
+  printf("]\n");
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function called by Rime for every packet received */
+static void recvPacket(struct unicast_conn *c, const linkaddr_t *from)
+{
+  unsigned int id = (unsigned int)from->u8[0] << 8 | from->u8[1];
+
+  if (sinkReceive(&sink, id, packetbuf_dataptr(), packetbuf_datalen()) < 0)
+    printf("Packet from %u.%u dropped\n", from->u8[0], from->u8[1]);
+}
+
+static const struct unicast_callbacks unicast_callbacks = {recvPacket};
+/***********************************************************************************/
+
+/*---------------------------------------------------------------------------*/
+PROCESS(sink_process, "Report sink process");
+AUTOSTART_PROCESSES(&sink_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(sink_process, ev, data)
+{
+  PROCESS_EXITHANDLER(unicast_close(&uc);)
+
+  PROCESS_BEGIN();
+  sinkInit(&sink, printReport, NULL);
+  unicast_open(&uc, TRANSPORT_CHANNEL, &unicast_callbacks);
+
+  while(1)
+  {
+    PROCESS_YIELD(); // all the work is done in recvPacket().
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
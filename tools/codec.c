@@ -0,0 +1,346 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Report Codec Benchmark and Decoder                                              */
+/*                                                                                 */
+/* Default mode: runs a recorded trace through the mote pipeline (sensor-proc.c),  */
+/* encodes every report with report-codec.c as the mote does, decodes it again and */
+/* checks the round trip against the fixed point values. Prints the encoded size   */
+/* per aggregation level against the size of the report as raw float32 (one count  */
+/* byte and 4 bytes per element), and the error of the decoded readings. The       */
+/* trace is run twice, with the aggregation of sensor-proc.h as configured and     */
+/* with the fixed levels at the plain thresholds (no hysteresis, no dwell, no      */
+/* adaptive aggregation, no heartbeats), to show the bytes the configuration       */
+/* saves. With -s, reports within the given lx of the last one sent go as          */
+/* heartbeats (SUPPRESS), and the error includes the staleness that costs.         */
+/*                                                                                 */
+/* -d mode: decodes the "Encoded X = ..." lines of a mote serial log and writes    */
+/* one CSV row per report: index, aggregation, x0..x11 in lx.                      */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o codec tools/codec.c tools/trace.c report-codec.c \             */
+/*       sensor-proc.c                                                             */
+/*                                                                                 */
+/* Usage: codec [-t low,high] [-H hysteresis] [-w dwell] [-a tolerance]            */
+/*              [-s suppress lx] trace                                             */
+/*        codec -d log                                                             */
+/*   -t, -H, -w and -a override ACTIVITY_LOW/HIGH, ACTIVITY_HYSTERESIS,            */
+/*   ACTIVITY_MIN_DWELL and AGGR_TOLERANCE; -s turns on SUPPRESS at that           */
+/*   SUPPRESS_LIGHT.                                                               */
+/*   trace is a binary trace (tools/trace-format.h) or text with the mote's        */
+/*   "Light: x lx, Temp: y C" lines or plain "light,temp" CSV.                     */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include "report-codec.h"
+#include "tools/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LINE_MAX_LEN 1024
+
+struct level_stats
+{
+  unsigned long reports;
+  unsigned long raw_bytes;
+  unsigned long encoded_bytes;
+  int min_bytes, max_bytes;
+};
+
+static struct sensor_pipeline pipeline;
+static struct report_codec encoder, decoder;
+static struct level_stats stats[WINDOW_LEN+1]; // by AggrElementsCount.
+static unsigned long mismatches;
+static double max_error, sum_error; // decoded readings against the raw ones, lx.
+static unsigned long readings;
+static unsigned long heartbeats;
+
+// classifier settings of the benchmark run.
+static float thresholds[ACTIVITY_LEVELS-1] = {ACTIVITY_LOW, ACTIVITY_HIGH};
+static float hysteresis = ACTIVITY_HYSTERESIS;
+static int min_dwell = ACTIVITY_MIN_DWELL;
+static float tolerance = AGGR_TOLERANCE;
+static float suppress = SUPPRESS ? SUPPRESS_LIGHT : 0; // lx, 0 for no heartbeats.
+
+/***********************************************************************************/
+/* function to run one reading through the pipeline and the codec */
+static void benchSample(float light_lx, float temp_c)
+{
+  unsigned char Enc[CODEC_MAX_BYTES];
+  float X[WINDOW_LEN];
+  long D[WINDOW_LEN], Q[WINDOW_LEN];
+  struct level_stats *st;
+  double err;
+  int EncLen, count, expected, i, j, start;
+
+  if (!(pipelineAddSample(&pipeline, light_lx, temp_c) & PIPELINE_MEASURE))
+    return;
+  pipelineMeasure(&pipeline, X);
+
+  // the fixed point values the decoder should get back.
+  if (suppress > 0 && !codecChanged(&encoder, X, pipeline.tolerance > 0 ?
+                                    pipeline.SegmentLen : NULL,
+                                    pipeline.AggrElementsCount, suppress))
+  {
+    memcpy(Q, encoder.prev, encoder.prev_count*sizeof(long));
+    expected = encoder.prev_count;
+    EncLen = codecEncodeHeartbeat(&encoder, Enc);
+    heartbeats++;
+  }
+  else if (pipeline.tolerance > 0)
+  {
+    EncLen = codecEncodeSegments(&encoder, X, pipeline.SegmentLen,
+                                 pipeline.AggrElementsCount, Enc);
+    for (j=0,start=0;j<pipeline.AggrElementsCount;start+=pipeline.SegmentLen[j++])
+    {
+      for (i=start;i<start+pipeline.SegmentLen[j];i++)
+        Q[i] = codecQuantize(X[j]);
+    }
+    expected = WINDOW_LEN;
+  }
+  else
+  {
+    EncLen = codecEncode(&encoder, X, pipeline.AggrElementsCount, Enc);
+    for (i=0;i<pipeline.AggrElementsCount;i++)
+      Q[i] = codecQuantize(X[i]);
+    expected = pipeline.AggrElementsCount;
+  }
+
+  if (codecDecode(&decoder, Enc, EncLen, D, &count) != EncLen || count != expected ||
+      memcmp(D, Q, count*sizeof(long)) != 0)
+  {
+    mismatches++;
+  }
+  else
+  {
+    // error of every reading of the window as the sink sees it.
+    for (i=0;i<WINDOW_LEN;i++)
+    {
+      err = (double)D[i*count/WINDOW_LEN] / CODEC_SCALE - pipeline.B[i];
+      err = err < 0 ? -err : err;
+      max_error = err > max_error ? err : max_error;
+      sum_error += err;
+      readings++;
+    }
+  }
+
+  st = &stats[pipeline.AggrElementsCount];
+  if (st->reports == 0 || EncLen < st->min_bytes)
+    st->min_bytes = EncLen;
+  if (EncLen > st->max_bytes)
+    st->max_bytes = EncLen;
+  st->reports++;
+  st->raw_bytes += 1 + 4*pipeline.AggrElementsCount;
+  if (pipeline.tolerance > 0)
+    st->raw_bytes += pipeline.AggrElementsCount; // a length byte per segment.
+  st->encoded_bytes += EncLen;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to run a whole trace through benchSample() */
+/* with a fresh pipeline, codec and statistics, the given classifier and */
+/* the given tolerance of adaptive aggregation and of heartbeats. */
+static void benchTrace(const struct trace *tr, float h, int dwell, float tol, float sup)
+{
+  float light, temp;
+  long s;
+
+  pipelineInit(&pipeline);
+  classifierInit(&pipeline.classifier, thresholds, h, dwell);
+  pipeline.tolerance = tol;
+  suppress = sup;
+  codecInit(&encoder);
+  codecInit(&decoder);
+  memset(stats, 0, sizeof(stats));
+  max_error = sum_error = 0;
+  readings = heartbeats = 0;
+
+  for (s=0;s<tr->count;s++)
+  {
+    traceSample(tr, s, &light, &temp);
+    benchSample(light, temp);
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add up the statistics of all aggregation levels */
+static void totalStats(struct level_stats *total)
+{
+  int i;
+
+  memset(total, 0, sizeof(*total));
+  for (i=1;i<=WINDOW_LEN;i++)
+  {
+    total->reports += stats[i].reports;
+    total->raw_bytes += stats[i].raw_bytes;
+    total->encoded_bytes += stats[i].encoded_bytes;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to print the compression of every aggregation level */
+static void printStats(void)
+{
+  struct level_stats total;
+  int i;
+
+  printf("aggregation  reports  raw bytes  encoded bytes  min  max  ratio\n");
+  for (i=1;i<=WINDOW_LEN;i++)
+  {
+    if (stats[i].reports == 0)
+      continue;
+    printf("%2d-element %9lu %10lu %14lu %4d %4d %6.2f\n", i, stats[i].reports,
+           stats[i].raw_bytes, stats[i].encoded_bytes, stats[i].min_bytes,
+           stats[i].max_bytes, (double)stats[i].raw_bytes / stats[i].encoded_bytes);
+  }
+  totalStats(&total);
+  if (total.reports > 0)
+    printf("all        %9lu %10lu %14lu           %6.2f\n", total.reports,
+           total.raw_bytes, total.encoded_bytes,
+           (double)total.raw_bytes / total.encoded_bytes);
+  printf("level changes: %lu\n", pipeline.classifier.changes);
+  if (suppress > 0)
+    printf("heartbeats: %lu of %lu reports\n", heartbeats, total.reports);
+  printf("error per reading: mean %.3f lx, max %.3f lx\n",
+         readings ? sum_error/readings : 0, max_error);
+  printf("round trip mismatches: %lu\n", mismatches);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to decode the encoded reports of a mote log to CSV */
+static int decodeLog(FILE *f)
+{
+  unsigned char Enc[CODEC_MAX_BYTES];
+  char line[LINE_MAX_LEN];
+  long D[WINDOW_LEN];
+  unsigned long index = 0;
+  unsigned int byte;
+  int EncLen, count, i;
+  const char *p;
+
+  printf("report,aggregation");
+  for (i=0;i<WINDOW_LEN;i++)
+    printf(",x%d", i);
+  printf("\n");
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    p = strstr(line, "Encoded X = ");
+    if (p == NULL)
+      continue;
+    p += 12;
+    for (EncLen=0;EncLen<CODEC_MAX_BYTES && sscanf(p, "%2x", &byte) == 1;EncLen++,p+=2)
+      Enc[EncLen] = (unsigned char)byte;
+
+    // a lost or garbled report leaves the decoder waiting for the next key frame.
+    if (codecDecode(&decoder, Enc, EncLen, D, &count) != EncLen)
+    {
+      codecInit(&decoder);
+      fprintf(stderr, "codec: report %lu not decodable\n", index++);
+      continue;
+    }
+    printf("%lu,%d", index++, count);
+    for (i=0;i<WINDOW_LEN;i++)
+    {
+      if (i<count)
+        printf(",%.2f", (double)D[i] / CODEC_SCALE);
+      else
+        printf(",");
+    }
+    printf("\n");
+  }
+  return 0;
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  struct level_stats plain, total;
+  struct trace tr = {0};
+  unsigned long plain_changes;
+  float sup;
+  int decode = 0, opt, rc;
+  FILE *f;
+
+  while ((opt = getopt(argc, argv, "dt:H:w:a:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'd':
+        decode = 1;
+        break;
+      case 't':
+        if (sscanf(optarg, "%f,%f", &thresholds[0], &thresholds[1]) != 2)
+        {
+          fprintf(stderr, "codec: -t takes low,high\n");
+          return 2;
+        }
+        break;
+      case 'H':
+        hysteresis = atof(optarg);
+        break;
+      case 'w':
+        min_dwell = atoi(optarg);
+        break;
+      case 'a':
+        tolerance = atof(optarg);
+        break;
+      case 's':
+        suppress = atof(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-t low,high] [-H hysteresis] [-w dwell] [-a tolerance]"
+                " [-s suppress lx] trace\n"
+                "       %s -d log\n", argv[0], argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc-1)
+  {
+    fprintf(stderr, "usage: %s [-t low,high] [-H hysteresis] [-w dwell] [-a tolerance]"
+            " [-s suppress lx] trace\n"
+            "       %s -d log\n", argv[0], argv[0]);
+    return 2;
+  }
+
+  if (decode)
+  {
+    f = fopen(argv[optind], "rb");
+    if (f == NULL)
+    {
+      perror(argv[optind]);
+      return 1;
+    }
+    codecInit(&decoder);
+    rc = decodeLog(f);
+    fclose(f);
+  }
+  else
+  {
+    if (traceOpen(argv[optind], &tr) != 0)
+      return 1;
+    // the plain thresholds and fixed levels first, as the reference.
+    sup = suppress;
+    benchTrace(&tr, 0, 1, 0, 0);
+    totalStats(&plain);
+    plain_changes = pipeline.classifier.changes;
+    benchTrace(&tr, hysteresis, min_dwell, tolerance, sup);
+    printStats();
+    totalStats(&total);
+    printf("plain fixed levels: %lu level changes, %lu raw bytes, %lu encoded bytes\n",
+           plain_changes, plain.raw_bytes, plain.encoded_bytes);
+    printf("saved: %.1f%% raw bytes, %.1f%% encoded bytes\n",
+           plain.raw_bytes ? 100.0*((double)plain.raw_bytes - total.raw_bytes) /
+                             plain.raw_bytes : 0,
+           plain.encoded_bytes ? 100.0*((double)plain.encoded_bytes -
+                                        total.encoded_bytes) / plain.encoded_bytes : 0);
+    traceClose(&tr);
+    rc = 0;
+  }
+  return rc != 0 || mismatches != 0;
+}
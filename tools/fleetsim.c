@@ -0,0 +1,373 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Fleet Simulator                                                                 */
+/*                                                                                 */
+/* Runs thousands of independent copies of the sensor_reading_process state        */
+/* machine on the host to estimate the report load a larger fleet puts on the      */
+/* server. Every mote has its own struct sensor_pipeline (B/T windows, readcount)  */
+/* and sampling timer (with a random phase and a few tens of ppm of clock drift)   */
+/* and reads a synthetic indoor light/temperature signal.                          */
+/*                                                                                 */
+/* Time is virtual and advances in epochs of one sampling period. Within an epoch  */
+/* the motes are cut into batches that a pool of worker threads runs; each worker  */
+/* owns a deque of batches, works from its bottom and steals from the top of the   */
+/* others when it runs dry.                                                        */
+/*                                                                                 */
+/* Reported: reports per wall-clock second, virtual-time speed-up, and the         */
+/* distribution of the per-report processing latency over all motes.               */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o fleetsim tools/fleetsim.c sensor-proc.c -lpthread              */
+/*                                                                                 */
+/* Usage: fleetsim [-n motes] [-s virtual seconds] [-j threads] [-b batch]         */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERIOD_MS 500      // CLOCK_CONF_SECOND/2 of the mote.
+#define LATENCY_BUCKETS 32 // log2 buckets of nanoseconds.
+
+struct mote
+{
+  struct sensor_pipeline pipeline;
+  double next_ms;    // virtual time of the next timer event.
+  double period_ms;  // PERIOD_MS with the clock drift of this mote.
+  uint32_t rng;
+  int light_adc;     // state of the synthetic light signal.
+  int lamp;
+  unsigned long reports;
+  uint64_t latency_sum_ns, latency_max_ns;
+};
+
+struct deque
+{
+  int *items;       // batch numbers.
+  int top, bottom;  // thieves take from top, the owner from bottom.
+  pthread_mutex_t lock;
+};
+
+struct worker
+{
+  int id;
+  pthread_t thread;
+  unsigned long reports, steals;
+  uint64_t histogram[LATENCY_BUCKETS];
+  struct stats light;  // light readings of the motes this worker ran.
+  long arena_mem[(REGRESS_MAX_SCRATCH_SIZE + sizeof(long)-1) / sizeof(long)];
+  struct arena scratch;
+};
+
+static struct mote *motes;
+static int motes_count = 10000;
+static int batch_size = 64;
+static int batches_count;
+static struct worker *workers;
+static struct deque *deques;
+static int workers_count;
+static double epoch_end_ms;
+static int stopping;
+static pthread_barrier_t epoch_start, epoch_done;
+
+/***********************************************************************************/
+/* function to get the next pseudo random number of a mote (xorshift32) */
+static uint32_t moteRandom(struct mote *m)
+{
+  m->rng ^= m->rng << 13;
+  m->rng ^= m->rng >> 17;
+  m->rng ^= m->rng << 5;
+  return m->rng;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to read the synthetic sensors of a mote */
+/* daylight drifting slowly, a lamp switching now and then, ADC noise. */
+static void moteSensors(struct mote *m, float *light_lx, float *temp_c)
+{
+  int adc;
+
+  if (moteRandom(m) % 600 == 0)
+    m->lamp = !m->lamp;
+  m->light_adc += (int)(moteRandom(m) % 5) - 2;
+  if (m->light_adc < 0)
+    m->light_adc = 0;
+  if (m->light_adc > 3000)
+    m->light_adc = 3000;
+  adc = m->light_adc + (m->lamp ? 900 : 0) + (int)(moteRandom(m) % 7) - 3;
+  *light_lx = lightFromADC(adc < 0 ? 0 : adc);
+  *temp_c = temperatureFromADC(1490 + m->light_adc/100 + (int)(moteRandom(m) % 5));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to run one timer event of a mote, as the loop body of */
+/* sensor_reading_process does */
+static void moteStep(struct mote *m, struct worker *w)
+{
+  struct timespec t0, t1;
+  float light_lx, temp_c, X[WINDOW_LEN];
+  int due, i;
+  uint64_t ns;
+
+  moteSensors(m, &light_lx, &temp_c);
+  due = pipelineAddSample(&m->pipeline, light_lx, temp_c);
+  if (!due)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (due & PIPELINE_MEASURE)
+  {
+    pipelineMeasure(&m->pipeline, X);
+    statsMerge(&w->light, &m->pipeline.halves[1]); // the readings since the last report.
+  }
+  if (due & PIPELINE_REGRESS)
+    pipelineRegress(&m->pipeline, &w->scratch);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  ns = (uint64_t)(t1.tv_sec - t0.tv_sec)*1000000000u + (t1.tv_nsec - t0.tv_nsec);
+  m->reports++;
+  m->latency_sum_ns += ns;
+  if (ns > m->latency_max_ns)
+    m->latency_max_ns = ns;
+  for (i=0;i<LATENCY_BUCKETS-1 && (ns >> (i+1)) != 0;i++)
+    ;
+  w->histogram[i]++;
+  w->reports++;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* work-stealing deque, one per worker */
+static int dequePopBottom(struct deque *d, int *item)
+{
+  int ok = 0;
+
+  pthread_mutex_lock(&d->lock);
+  if (d->bottom > d->top)
+  {
+    *item = d->items[--d->bottom];
+    ok = 1;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+static int dequeStealTop(struct deque *d, int *item)
+{
+  int ok = 0;
+
+  if (pthread_mutex_trylock(&d->lock) != 0)
+    return 0;
+  if (d->bottom > d->top)
+  {
+    *item = d->items[d->top++];
+    ok = 1;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to run the motes of one batch up to the end of the epoch */
+static void runBatch(int batch, struct worker *w)
+{
+  struct mote *m;
+  int first = batch*batch_size, last = first+batch_size, i;
+
+  if (last > motes_count)
+    last = motes_count;
+  for (i=first;i<last;i++)
+  {
+    m = &motes[i];
+    while (m->next_ms < epoch_end_ms)
+    {
+      moteStep(m, w);
+      m->next_ms += m->period_ms;
+    }
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function run by every worker thread, one iteration per epoch */
+static void *workerLoop(void *arg)
+{
+  struct worker *w = arg;
+  int batch, victim, k, busy;
+
+  for (;;)
+  {
+    pthread_barrier_wait(&epoch_start);
+    if (stopping)
+      return NULL;
+
+    // no batch is added during an epoch, so once every deque has been
+    // found empty the epoch is done for this worker.
+    for (;;)
+    {
+      while (dequePopBottom(&deques[w->id], &batch))
+        runBatch(batch, w);
+
+      busy = 0;
+      for (k=1;k<workers_count;k++)
+      {
+        victim = (w->id + k) % workers_count;
+        if (dequeStealTop(&deques[victim], &batch))
+        {
+          w->steals++;
+          runBatch(batch, w);
+          busy = 1;
+          break;
+        }
+        pthread_mutex_lock(&deques[victim].lock);
+        busy |= deques[victim].bottom > deques[victim].top;
+        pthread_mutex_unlock(&deques[victim].lock);
+      }
+      if (!busy)
+        break;
+    }
+    pthread_barrier_wait(&epoch_done);
+  }
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  struct timespec t0, t1;
+  uint64_t histogram[LATENCY_BUCKETS] = {0};
+  struct stats light;
+  unsigned long reports = 0, steals = 0, seen;
+  double virtual_s = 3600, elapsed, now_ms, mean_ns, mote_mean_max = 0;
+  uint64_t mote_max = 0;
+  int opt, i, b, k, pct;
+  static const int percentiles[] = {50, 90, 99, 100};
+
+  workers_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt(argc, argv, "n:s:j:b:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        motes_count = atoi(optarg);
+        break;
+      case 's':
+        virtual_s = atof(optarg);
+        break;
+      case 'j':
+        workers_count = atoi(optarg);
+        break;
+      case 'b':
+        batch_size = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n motes] [-s virtual seconds] [-j threads] [-b batch]\n",
+                argv[0]);
+        return 2;
+    }
+  }
+  if (motes_count < 1 || batch_size < 1 || workers_count < 1)
+  {
+    fprintf(stderr, "fleetsim: motes, batch and threads must be positive\n");
+    return 2;
+  }
+
+  motes = calloc(motes_count, sizeof(*motes));
+  for (i=0;i<motes_count;i++)
+  {
+    pipelineInit(&motes[i].pipeline);
+    motes[i].rng = 2463534242u + 7919u*i;
+    motes[i].period_ms = PERIOD_MS * (1 + ((int)(moteRandom(&motes[i]) % 101) - 50)*1e-6);
+    motes[i].next_ms = moteRandom(&motes[i]) % PERIOD_MS;
+    motes[i].light_adc = 200 + moteRandom(&motes[i]) % 1500;
+  }
+
+  batches_count = (motes_count + batch_size-1) / batch_size;
+  workers = calloc(workers_count, sizeof(*workers));
+  deques = calloc(workers_count, sizeof(*deques));
+  pthread_barrier_init(&epoch_start, NULL, workers_count+1);
+  pthread_barrier_init(&epoch_done, NULL, workers_count+1);
+  for (i=0;i<workers_count;i++)
+  {
+    deques[i].items = malloc(batches_count*sizeof(int));
+    pthread_mutex_init(&deques[i].lock, NULL);
+    workers[i].id = i;
+    arenaInit(&workers[i].scratch, workers[i].arena_mem, sizeof(workers[i].arena_mem));
+    pthread_create(&workers[i].thread, NULL, workerLoop, &workers[i]);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (now_ms=0;now_ms<virtual_s*1000;now_ms+=PERIOD_MS)
+  {
+    // deal the batches round-robin; stealing evens out the rest.
+    for (i=0;i<workers_count;i++)
+      deques[i].top = deques[i].bottom = 0;
+    for (b=0;b<batches_count;b++)
+    {
+      k = b % workers_count;
+      deques[k].items[deques[k].bottom++] = b;
+    }
+    epoch_end_ms = now_ms + PERIOD_MS;
+    pthread_barrier_wait(&epoch_start);
+    pthread_barrier_wait(&epoch_done);
+  }
+  stopping = 1;
+  pthread_barrier_wait(&epoch_start);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  // per-worker statistics reduce in any order.
+  statsInit(&light);
+  for (i=0;i<workers_count;i++)
+  {
+    pthread_join(workers[i].thread, NULL);
+    statsMerge(&light, &workers[i].light);
+    reports += workers[i].reports;
+    steals += workers[i].steals;
+    for (k=0;k<LATENCY_BUCKETS;k++)
+      histogram[k] += workers[i].histogram[k];
+  }
+  for (i=0;i<motes_count;i++)
+  {
+    if (motes[i].latency_max_ns > mote_max)
+      mote_max = motes[i].latency_max_ns;
+    if (motes[i].reports > 0)
+    {
+      mean_ns = (double)motes[i].latency_sum_ns / motes[i].reports;
+      if (mean_ns > mote_mean_max)
+        mote_mean_max = mean_ns;
+    }
+  }
+
+  elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+  printf("motes %d, virtual time %.0f s, %d threads, batch %d\n",
+         motes_count, virtual_s, workers_count, batch_size);
+  printf("wall time %.3f s, speed-up %.0fx over real time\n",
+         elapsed, elapsed > 0 ? virtual_s/elapsed : 0);
+  printf("reports %lu (%.1f/s per mote virtual), %.0f reports/s wall, %lu steals\n",
+         reports, reports/virtual_s/motes_count, elapsed > 0 ? reports/elapsed : 0, steals);
+
+  // latency percentiles, as the upper bound of the log2 bucket.
+  for (pct=0;pct<(int)(sizeof(percentiles)/sizeof(percentiles[0]));pct++)
+  {
+    seen = 0;
+    for (k=0;k<LATENCY_BUCKETS;k++)
+    {
+      seen += histogram[k];
+      if (seen*100 >= (unsigned long)percentiles[pct]*reports)
+        break;
+    }
+    printf("latency p%d < %llu ns\n", percentiles[pct], 2ull << k);
+  }
+  printf("fleet light: %lu readings, mean %.1f lx, std %.1f lx, min %.1f lx, max %.1f lx\n",
+         light.count, light.mean, statsStdDev(&light), light.min, light.max);
+  printf("worst per-mote mean latency %.0f ns, worst single report %llu ns\n",
+         mote_mean_max, (unsigned long long)mote_max);
+  return 0;
+}
@@ -0,0 +1,360 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Kernel Benchmark                                                                */
+/*                                                                                 */
+/* Times the host kernels of tools/kernels.h against the scalar code they stand    */
+/* in for, and checks that they agree, on random windows of 12 to 4096 readings    */
+/* on the light sensor steps (so some pairs of readings are equal):                */
+/*   mean+ssd  kernelMeanSSD() against statsAddBlock(), within 3e-6 relative       */
+/*   4-into-1  kernelBlockMean() against the block mean of aggregateBlocks(),      */
+/*             within 3e-6 relative                                                */
+/*   slopes    kernelPairSlopes() against the pair loop of getTheilSen(), bit for  */
+/*             bit                                                                 */
+/* and the mote code against the code it replaced, bit for bit:                    */
+/*   median    getMedian() against the in-place exchange sort it replaced, on      */
+/*             WINDOW_LEN and PAIR_COUNT elements                                  */
+/*   aggregate aggregate() against the unrolled 12-reading code it replaced, per   */
+/*             level (only built with WINDOW_LEN 12)                               */
+/* Times are per call on the host; the exit status is 1 on any mismatch.           */
+/*                                                                                 */
+/* Build (from the top of the repository), once per instruction set:               */
+/*   gcc -O2 -mavx2 -I. -o kernelbench tools/kernelbench.c tools/kernels.c \       */
+/*       sensor-proc.c -lm                                                         */
+/*   gcc -O2 -I. -o kernelbench-sse2 tools/kernelbench.c tools/kernels.c \         */
+/*       sensor-proc.c -lm                                                         */
+/*                                                                                 */
+/* Usage: kernelbench [-w work] [-s seed]                                          */
+/*   work is the readings (or pairs) each timing covers, default 20000000; every   */
+/*   kernel is called at least 100 times.                                          */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include "tools/kernels.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define POOL 16        // windows of each size, cycled through by the timings.
+#define N_MAX 4096     // longest window.
+#define MIN_CALLS 100
+#define REL_TOL 3e-6   // agreement of the reordered float sums.
+
+static const int sizes[] = {12, 64, 256, 1024, 4096};
+
+static float B[POOL][N_MAX], T[POOL][N_MAX];
+static float slopes_ref[N_MAX*(N_MAX-1)/2], slopes[N_MAX*(N_MAX-1)/2 + 8];
+static volatile float sink; // keeps the results of the timed calls live.
+static int failed;
+
+/* times calls iterations of body into ns, per call. */
+#define TIMED(ns, calls, body) \
+  do { \
+    struct timespec t0_, t1_; \
+    long c_; \
+    clock_gettime(CLOCK_MONOTONIC, &t0_); \
+    for (c_=0;c_<(calls);c_++) { body; } \
+    clock_gettime(CLOCK_MONOTONIC, &t1_); \
+    (ns) = ((t1_.tv_sec - t0_.tv_sec)*1e9 + (t1_.tv_nsec - t0_.tv_nsec)) / (calls); \
+  } while (0)
+
+/***********************************************************************************/
+/* function to fill the pool with windows of n readings */
+/* light on whole ADC steps, temperature on a line plus noise. */
+static void fillPool(int n)
+{
+  int w, i;
+
+  for (w=0;w<POOL;w++)
+  {
+    for (i=0;i<n;i++)
+    {
+      B[w][i] = (rand() % 4096) * (float)LIGHT_STEP;
+      T[w][i] = 20 + 0.004f*B[w][i] + (rand() % 101 - 50) * 0.001f;
+    }
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the relative difference of a against the reference r */
+static double relDiff(float a, float r)
+{
+  if (a == r)
+    return 0;
+  return fabs((double)a - r) / (fabs(r) > 1e-30 ? fabs(r) : 1e-30);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to print one row and count a mismatch */
+static void report(const char *name, int n, const char *ref, double ns_ref, double ns,
+                   long mismatches, double max_diff)
+{
+  printf("%-9s %5d  %-13s %11.1f %11.1f %8.2fx %10ld %12.2e\n", name, n, ref, ns_ref,
+         ns, ns_ref/ns, mismatches, max_diff);
+  if (mismatches != 0)
+    failed = 1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the mean and SSD of B[0..n-1] the mote's way */
+static void scalarMeanSSD(const float B[], int n, float *mean, float *ssd)
+{
+  struct stats s;
+
+  statsInit(&s);
+  statsAddBlock(&s, B, n);
+  *mean = s.mean;
+  *ssd = s.M2;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the block means the way reduceBlocks() sums them */
+static void scalarBlockMean(const float B[], int n, int len, float X[])
+{
+  float x;
+  int b, i;
+
+  for (b=0;b<n/len;b++,B+=len)
+  {
+    x = B[0];
+    for (i=1;i<len;i++)
+      x += B[i];
+    X[b] = x / len;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the pair slopes in the loop of getTheilSen() */
+static int scalarPairSlopes(const float B[], const float T[], int n, float slopes[])
+{
+  int count = 0, i, j;
+
+  for (i=0;i<n;i++)
+  {
+    for (j=i+1;j<n;j++)
+    {
+      if (B[i] != B[j])
+        slopes[count++] = (T[j] - T[i]) / (B[j] - B[i]);
+    }
+  }
+  return count;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the median by the in-place exchange sort getMedian() used */
+static float sortMedian(float TS[], int TSElementsCount)
+{
+  float intermed;
+  int i, j;
+
+  for (i=0;i<TSElementsCount-1;i++)
+  {
+    for (j=i+1;j<=TSElementsCount-1;j++)
+    {
+      if (TS[i] > TS[j])
+      {
+        intermed = TS[i];
+        TS[i] = TS[j];
+        TS[j] = intermed;
+      }
+    }
+  }
+  if (TSElementsCount % 2 == 0)
+    return (TS[(TSElementsCount/2)-1] + TS[(TSElementsCount/2)])/2;
+  return TS[TSElementsCount/2];
+}
+/***********************************************************************************/
+
+#if WINDOW_LEN == 12
+/***********************************************************************************/
+/* function to aggregate as the unrolled code aggregateBlocks() replaced */
+static void unrolledAggregate(const float B[], float X[], int AggrElementsCount)
+{
+  int i;
+
+  if (AggrElementsCount==1)
+  {
+    X[0] = (B[0]+B[1]+B[2]+B[3]+B[4]+B[5]+B[6]+B[7]+B[8]+B[9]+B[10]+B[11])/12;
+  }
+  if (AggrElementsCount==3)
+  {
+    X[0] = (B[0]+B[1]+B[2]+B[3])/4;
+    X[1] = (B[4]+B[5]+B[6]+B[7])/4;
+    X[2] = (B[8]+B[9]+B[10]+B[11])/4;
+  }
+  if (AggrElementsCount==WINDOW_LEN)
+  {
+    for (i=0;i<WINDOW_LEN;i++)
+      X[i] = B[i];
+  }
+}
+/***********************************************************************************/
+#endif
+
+/***********************************************************************************/
+/* function to check and time the kernels on windows of n readings */
+static void benchKernels(int n, long work)
+{
+  float mean_ref, ssd_ref, mean, ssd, X_ref[N_MAX/4], X[N_MAX/4];
+  double ns_ref, ns, diff;
+  long calls, mismatches;
+  int count_ref, count, w, b;
+
+  fillPool(n);
+
+  // mean and sum of squared distances.
+  mismatches = 0;
+  diff = 0;
+  for (w=0;w<POOL;w++)
+  {
+    scalarMeanSSD(B[w], n, &mean_ref, &ssd_ref);
+    kernelMeanSSD(B[w], n, &mean, &ssd);
+    diff = fmax(diff, fmax(relDiff(mean, mean_ref), relDiff(ssd, ssd_ref)));
+    if (relDiff(mean, mean_ref) > REL_TOL || relDiff(ssd, ssd_ref) > REL_TOL)
+      mismatches++;
+  }
+  calls = work/n > MIN_CALLS ? work/n : MIN_CALLS;
+  TIMED(ns_ref, calls, scalarMeanSSD(B[c_ % POOL], n, &mean, &ssd); sink += ssd);
+  TIMED(ns, calls, kernelMeanSSD(B[c_ % POOL], n, &mean, &ssd); sink += ssd);
+  report("mean+ssd", n, "statsAddBlock", ns_ref, ns, mismatches, diff);
+
+  // block means of 4 readings.
+  mismatches = 0;
+  diff = 0;
+  for (w=0;w<POOL;w++)
+  {
+    scalarBlockMean(B[w], n, 4, X_ref);
+    kernelBlockMean(B[w], n, 4, X);
+    for (b=0;b<n/4;b++)
+    {
+      diff = fmax(diff, relDiff(X[b], X_ref[b]));
+      if (relDiff(X[b], X_ref[b]) > REL_TOL)
+        mismatches++;
+    }
+  }
+  TIMED(ns_ref, calls, scalarBlockMean(B[c_ % POOL], n, 4, X); sink += X[0]);
+  TIMED(ns, calls, kernelBlockMean(B[c_ % POOL], n, 4, X); sink += X[0]);
+  report("4-into-1", n, "block loop", ns_ref, ns, mismatches, diff);
+
+  // pairwise slopes, bit for bit.
+  mismatches = 0;
+  for (w=0;w<POOL;w++)
+  {
+    count_ref = scalarPairSlopes(B[w], T[w], n, slopes_ref);
+    count = kernelPairSlopes(B[w], T[w], n, slopes);
+    if (count != count_ref || memcmp(slopes, slopes_ref, count*sizeof(float)) != 0)
+      mismatches++;
+  }
+  calls = work/((long)n*(n-1)/2) > MIN_CALLS ? work/((long)n*(n-1)/2) : MIN_CALLS;
+  TIMED(ns_ref, calls, sink += scalarPairSlopes(B[c_ % POOL], T[c_ % POOL], n, slopes));
+  TIMED(ns, calls, sink += kernelPairSlopes(B[c_ % POOL], T[c_ % POOL], n, slopes));
+  report("slopes", n, "pair loop", ns_ref, ns, mismatches, 0);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to check and time getMedian() against the sort on n elements */
+static void benchMedian(int n, long work)
+{
+  float Copy[PAIR_COUNT], Scratch[PAIR_COUNT], median_ref, median;
+  double ns_ref, ns, diff = 0;
+  long calls, mismatches = 0;
+  int w;
+
+  fillPool(n);
+  for (w=0;w<POOL;w++)
+  {
+    memcpy(Copy, B[w], n*sizeof(float));
+    median_ref = sortMedian(Copy, n);
+    median = getMedian(B[w], n, Scratch);
+    diff = fmax(diff, relDiff(median, median_ref));
+    if (median != median_ref)
+      mismatches++;
+  }
+  calls = work/n > MIN_CALLS ? work/n : MIN_CALLS;
+  TIMED(ns_ref, calls, memcpy(Copy, B[c_ % POOL], n*sizeof(float));
+        sink += sortMedian(Copy, n));
+  TIMED(ns, calls, sink += getMedian(B[c_ % POOL], n, Scratch));
+  report("median", n, "exchange sort", ns_ref, ns, mismatches, diff);
+}
+/***********************************************************************************/
+
+#if WINDOW_LEN == 12
+/***********************************************************************************/
+/* function to check and time aggregate() against the unrolled code per level */
+static void benchAggregate(const char *name, int AggrElementsCount, long work)
+{
+  float X_ref[WINDOW_LEN], X[WINDOW_LEN];
+  double ns_ref, ns;
+  long calls, mismatches = 0;
+  int w;
+
+  fillPool(WINDOW_LEN);
+  for (w=0;w<POOL;w++)
+  {
+    unrolledAggregate(B[w], X_ref, AggrElementsCount);
+    aggregate(B[w], X, AggrElementsCount);
+    if (memcmp(X, X_ref, AggrElementsCount*sizeof(float)) != 0)
+      mismatches++;
+  }
+  calls = work/WINDOW_LEN;
+  TIMED(ns_ref, calls, unrolledAggregate(B[c_ % POOL], X, AggrElementsCount);
+        sink += X[0]);
+  TIMED(ns, calls, aggregate(B[c_ % POOL], X, AggrElementsCount); sink += X[0]);
+  report(name, WINDOW_LEN, "unrolled", ns_ref, ns, mismatches, 0);
+}
+/***********************************************************************************/
+#endif
+
+int main(int argc, char *argv[])
+{
+  long work = 20000000;
+  unsigned int seed = 1;
+  int opt, s;
+
+  while ((opt = getopt(argc, argv, "w:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'w':
+        work = atol(optarg);
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-w work] [-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc || work <= 0)
+  {
+    fprintf(stderr, "usage: %s [-w work] [-s seed]\n", argv[0]);
+    return 2;
+  }
+  srand(seed);
+  kernelInit();
+
+  printf("kernels: %s, WINDOW_LEN %d, %d windows per size\n", kernel_isa, WINDOW_LEN,
+         POOL);
+  printf("kernel        n  reference      ref ns/call     ns/call  speed-up mismatches"
+         " max rel diff\n");
+  for (s=0;s<(int)(sizeof(sizes)/sizeof(sizes[0]));s++)
+    benchKernels(sizes[s], work);
+  benchMedian(WINDOW_LEN, work);
+  benchMedian(PAIR_COUNT, work);
+#if WINDOW_LEN == 12
+  benchAggregate("12-into-1", 1, work);
+  benchAggregate("4-into-1", 3, work);
+  benchAggregate("1-into-1", WINDOW_LEN, work);
+#endif
+  return failed;
+}
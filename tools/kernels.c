@@ -0,0 +1,292 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Vectorized Host Kernels, see kernels.h                                          */
+/*                                                                                 */
+/***********************************************************************************/
+#include "tools/kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+const char *kernel_isa = "avx2";
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+const char *kernel_isa = "sse2";
+#else
+const char *kernel_isa = "scalar";
+#endif
+
+#if defined(__AVX2__)
+/***********************************************************************************/
+/* horizontal sum of the 8 lanes */
+static float hsum8(__m256 v)
+{
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* permutation moving the lanes selected by an 8-bit mask to the front */
+static __m256i compactLUT[256];
+
+static void initCompactLUT(void)
+{
+  int m, i, k;
+  int idx[8];
+
+  for (m=0;m<256;m++)
+  {
+    k = 0;
+    for (i=0;i<8;i++)
+      if (m & (1<<i))
+        idx[k++] = i;
+    for (;k<8;k++)
+      idx[k] = 0;
+    compactLUT[m] = _mm256_setr_epi32(idx[0], idx[1], idx[2], idx[3],
+                                      idx[4], idx[5], idx[6], idx[7]);
+  }
+}
+/***********************************************************************************/
+#elif defined(__SSE2__)
+/***********************************************************************************/
+/* horizontal sum of the 4 lanes */
+static float hsum4(__m128 s)
+{
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+}
+/***********************************************************************************/
+#endif
+
+/***********************************************************************************/
+void kernelInit(void)
+{
+#if defined(__AVX2__)
+  initCompactLUT();
+#endif
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+void kernelMeanSSD(const float B[], int n, float *mean, float *ssd)
+{
+  float Sum = 0, Mean, SumofDistSquares = 0, d;
+  int i = 0;
+
+#if defined(__AVX2__)
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(), m, v;
+
+  for (;i+16<=n;i+=16)
+  {
+    acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(B+i));
+    acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(B+i+8));
+  }
+  for (;i+8<=n;i+=8)
+    acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(B+i));
+  Sum = hsum8(_mm256_add_ps(acc0, acc1));
+  for (;i<n;i++)
+    Sum += B[i];
+  Mean = Sum/n;
+
+  m = _mm256_set1_ps(Mean);
+  acc0 = acc1 = _mm256_setzero_ps();
+  for (i=0;i+16<=n;i+=16)
+  {
+    v = _mm256_sub_ps(_mm256_loadu_ps(B+i), m);
+    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(v, v));
+    v = _mm256_sub_ps(_mm256_loadu_ps(B+i+8), m);
+    acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(v, v));
+  }
+  for (;i+8<=n;i+=8)
+  {
+    v = _mm256_sub_ps(_mm256_loadu_ps(B+i), m);
+    acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(v, v));
+  }
+  SumofDistSquares = hsum8(_mm256_add_ps(acc0, acc1));
+#elif defined(__SSE2__)
+  __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), m, v;
+
+  for (;i+8<=n;i+=8)
+  {
+    acc0 = _mm_add_ps(acc0, _mm_loadu_ps(B+i));
+    acc1 = _mm_add_ps(acc1, _mm_loadu_ps(B+i+4));
+  }
+  for (;i+4<=n;i+=4)
+    acc0 = _mm_add_ps(acc0, _mm_loadu_ps(B+i));
+  Sum = hsum4(_mm_add_ps(acc0, acc1));
+  for (;i<n;i++)
+    Sum += B[i];
+  Mean = Sum/n;
+
+  m = _mm_set1_ps(Mean);
+  acc0 = acc1 = _mm_setzero_ps();
+  for (i=0;i+8<=n;i+=8)
+  {
+    v = _mm_sub_ps(_mm_loadu_ps(B+i), m);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(v, v));
+    v = _mm_sub_ps(_mm_loadu_ps(B+i+4), m);
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(v, v));
+  }
+  for (;i+4<=n;i+=4)
+  {
+    v = _mm_sub_ps(_mm_loadu_ps(B+i), m);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(v, v));
+  }
+  SumofDistSquares = hsum4(_mm_add_ps(acc0, acc1));
+#else
+  for (;i<n;i++)
+    Sum += B[i];
+  Mean = Sum/n;
+  i = 0;
+#endif
+
+  for (;i<n;i++)
+  {
+    d = B[i]-Mean;
+    SumofDistSquares += d*d;
+  }
+  *mean = Mean;
+  *ssd = SumofDistSquares;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+void kernelBlockMean(const float B[], int n, int len, float X[])
+{
+  int blocks = n/len, b, i;
+  float s;
+
+#if defined(__AVX2__)
+  if (len == 4)
+  {
+    // pairwise horizontal adds leave the block sums in lane order
+    // 0 2 4 6 | 1 3 5 7, one permute puts them back in order.
+    __m256 h01, h23, quarter = _mm256_set1_ps(0.25f);
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    for (b=0;b+8<=blocks;b+=8)
+    {
+      h01 = _mm256_hadd_ps(_mm256_loadu_ps(B+4*b), _mm256_loadu_ps(B+4*b+8));
+      h23 = _mm256_hadd_ps(_mm256_loadu_ps(B+4*b+16), _mm256_loadu_ps(B+4*b+24));
+      _mm256_storeu_ps(X+b, _mm256_mul_ps(_mm256_permutevar8x32_ps(
+                                            _mm256_hadd_ps(h01, h23), order), quarter));
+    }
+    for (;b<blocks;b++)
+      X[b] = (B[4*b]+B[4*b+1]+B[4*b+2]+B[4*b+3])/4;
+    return;
+  }
+#elif defined(__SSE2__)
+  if (len == 4)
+  {
+    // transpose 4 blocks at a time and add them up lane-wise.
+    __m128 r0, r1, r2, r3, quarter = _mm_set1_ps(0.25f);
+
+    for (b=0;b+4<=blocks;b+=4)
+    {
+      r0 = _mm_loadu_ps(B+4*b);
+      r1 = _mm_loadu_ps(B+4*b+4);
+      r2 = _mm_loadu_ps(B+4*b+8);
+      r3 = _mm_loadu_ps(B+4*b+12);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(X+b, _mm_mul_ps(_mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3)),
+                                     quarter));
+    }
+    for (;b<blocks;b++)
+      X[b] = (B[4*b]+B[4*b+1]+B[4*b+2]+B[4*b+3])/4;
+    return;
+  }
+#endif
+
+  for (b=0;b<blocks;b++)
+  {
+    s = 0;
+    for (i=0;i<len;i++)
+      s += B[b*len+i];
+    X[b] = s/len;
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+int kernelPairSlopes(const float B[], const float T[], int n, float slopes[])
+{
+  int count = 0, i, j;
+  float dB;
+
+#if defined(__AVX2__)
+  __m256 bi, ti, db, dt;
+  int mask;
+
+  for (i=0;i<n;i++)
+  {
+    bi = _mm256_set1_ps(B[i]);
+    ti = _mm256_set1_ps(T[i]);
+    for (j=i+1;j+8<=n;j+=8)
+    {
+      // divide all 8 lanes, then keep the lanes with B[i] != B[j] in order.
+      db = _mm256_sub_ps(_mm256_loadu_ps(B+j), bi);
+      dt = _mm256_sub_ps(_mm256_loadu_ps(T+j), ti);
+      mask = _mm256_movemask_ps(_mm256_cmp_ps(db, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+      _mm256_storeu_ps(slopes+count,
+                       _mm256_permutevar8x32_ps(_mm256_div_ps(dt, db), compactLUT[mask]));
+      count += __builtin_popcount(mask);
+    }
+    for (;j<n;j++)
+    {
+      dB = B[j]-B[i];
+      slopes[count] = (T[j]-T[i])/dB;
+      count += dB != 0;
+    }
+  }
+#elif defined(__SSE2__)
+  __m128 bi, ti, db, dt;
+  float s[4];
+  int mask, k;
+
+  for (i=0;i<n;i++)
+  {
+    bi = _mm_set1_ps(B[i]);
+    ti = _mm_set1_ps(T[i]);
+    for (j=i+1;j+4<=n;j+=4)
+    {
+      db = _mm_sub_ps(_mm_loadu_ps(B+j), bi);
+      dt = _mm_sub_ps(_mm_loadu_ps(T+j), ti);
+      mask = _mm_movemask_ps(_mm_cmpneq_ps(db, _mm_setzero_ps()));
+      if (mask == 0xf)
+      {
+        _mm_storeu_ps(slopes+count, _mm_div_ps(dt, db));
+        count += 4;
+        continue;
+      }
+      _mm_storeu_ps(s, _mm_div_ps(dt, db));
+      // branch-free compaction: always store, only advance on a kept lane.
+      for (k=0;k<4;k++)
+      {
+        slopes[count] = s[k];
+        count += (mask >> k) & 1;
+      }
+    }
+    for (;j<n;j++)
+    {
+      dB = B[j]-B[i];
+      slopes[count] = (T[j]-T[i])/dB;
+      count += dB != 0;
+    }
+  }
+#else
+  for (i=0;i<n;i++)
+  {
+    for (j=i+1;j<n;j++)
+    {
+      dB = B[j]-B[i];
+      if (dB != 0)
+        slopes[count++] = (T[j]-T[i])/dB;
+    }
+  }
+#endif
+  return count;
+}
+/***********************************************************************************/
@@ -0,0 +1,39 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Vectorized Host Kernels                                                         */
+/*                                                                                 */
+/* Host versions of the hot loops of sensor-proc.c for fleet-wide reprocessing,    */
+/* for windows of any length. The instruction set is picked at compile time:       */
+/* AVX2 with -mavx2, SSE2 on any x86-64, plain C otherwise.                        */
+/*                                                                                 */
+/* kernelPairSlopes() divides out the slopes of the pairs of getTheilSen(), in     */
+/* its pair order, as IEEE floats; the mote ranks them as fixed point fractions    */
+/* instead, so the medians agree to within the rounding of the sensor steps. The   */
+/* sums of kernelMeanSSD() and kernelBlockMean() are accumulated in a different    */
+/* order and match the mote code to within float rounding (relative 3e-6 on 12 to  */
+/* 4096 readings).                                                                 */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+/* name of the compiled-in instruction set, "avx2", "sse2" or "scalar". */
+extern const char *kernel_isa;
+
+/* sets up the lookup tables, call once before any other kernel. */
+void kernelInit(void);
+
+/* mean and sum of squared distances to the mean of B[0..n-1], two passes */
+/* like getStdDev(). */
+void kernelMeanSSD(const float B[], int n, float *mean, float *ssd);
+
+/* block means: X[b] = mean of B[b*len .. b*len+len-1] for b < n/len. */
+/* len 4 is the 4-into-1 aggregation, len n the 12-into-1. */
+void kernelBlockMean(const float B[], int n, int len, float X[]);
+
+/* all pairwise slopes (T[j]-T[i])/(B[j]-B[i]), i < j, skipping B[i] == B[j], */
+/* in the order of getTheilSen(). slopes must hold n(n-1)/2 + 8 elements; */
+/* returns the number of slopes. */
+int kernelPairSlopes(const float B[], const float T[], int n, float slopes[]);
+
+#endif /* KERNELS_H_ */
@@ -0,0 +1,171 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Serial Log to Binary Trace Converter                                            */
+/*                                                                                 */
+/* Turns the printf output of the mote ("Light: x lx, Temp: y C") into the binary  */
+/* trace format of trace-format.h. The printed values are mapped back to the raw   */
+/* ADC readings by inverting lightFromADC()/temperatureFromADC(); the 3 printed    */
+/* decimals are far finer than one ADC step, so the readings are recovered exactly.*/
+/*                                                                                 */
+/* Lines may carry a Cooja log prefix; a leading time in milliseconds or as        */
+/* [HH:]MM:SS.mmm becomes the record time, otherwise readings are spaced by the    */
+/* sampling period.                                                                */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o log2trace tools/log2trace.c -lm                                */
+/*                                                                                 */
+/* Usage: log2trace [-p period_ms] [-m mote_id] log trace                          */
+/*                                                                                 */
+/***********************************************************************************/
+#include "tools/trace-format.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LINE_MAX_LEN 1024
+
+/***********************************************************************************/
+/* function to map lux back to the light ADC reading */
+/* inverse of lightFromADC(): lux = ADC * 1.5/4096 / 100000 * 0.625e9. */
+static uint16_t lightToADC(double light_lx)
+{
+  long adc = lround(light_lx * 4096 / 9375);
+  return adc < 0 ? 0 : adc > 0xffff ? 0xffff : (uint16_t)adc;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to map degrees C back to the temperature ADC reading */
+/* inverse of temperatureFromADC() for the simulated Sky mote. Note that d1()/d2() */
+/* print temperatures between -1 and 0 C without their sign. */
+static uint16_t temperatureToADC(double temp_c)
+{
+  long adc = lround((temp_c + 39.6) / 0.04);
+  return adc < 0 ? 0 : adc > 0xffff ? 0xffff : (uint16_t)adc;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to read the time prefix of a log line */
+/* returns 1 and the time in ms for "12345<space>" or "[HH:]MM:SS.mmm<space>". */
+static int parseTime(const char *line, uint32_t *time_ms)
+{
+  unsigned long fields[3];
+  unsigned long ms = 0;
+  int nfields = 0, digits;
+  const char *p = line;
+  char *end;
+
+  if (!isdigit((unsigned char)*p))
+    return 0;
+
+  for (;;)
+  {
+    fields[nfields++] = strtoul(p, &end, 10);
+    p = end;
+    if (*p != ':' || nfields == 3)
+      break;
+    p++;
+  }
+  if (*p == '.' && nfields > 1)
+  {
+    p++;
+    for (digits=0;digits<3 && isdigit((unsigned char)*p);digits++,p++)
+      ms = ms*10 + (*p - '0');
+    for (;digits<3;digits++)
+      ms *= 10;
+  }
+  if (!isspace((unsigned char)*p))
+    return 0;
+
+  if (nfields == 1)
+    *time_ms = (uint32_t)fields[0];
+  else if (nfields == 2)
+    *time_ms = (uint32_t)((fields[0]*60 + fields[1])*1000 + ms);
+  else
+    *time_ms = (uint32_t)(((fields[0]*60 + fields[1])*60 + fields[2])*1000 + ms);
+  return 1;
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  struct trace_header hdr;
+  struct trace_record rec;
+  char line[LINE_MAX_LEN];
+  const char *p, *q;
+  FILE *in, *out;
+  uint32_t period_ms = 500, mote_id = 0, time_ms;
+  uint64_t count = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "p:m:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'p':
+        period_ms = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case 'm':
+        mote_id = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-p period_ms] [-m mote_id] log trace\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc-2)
+  {
+    fprintf(stderr, "usage: %s [-p period_ms] [-m mote_id] log trace\n", argv[0]);
+    return 2;
+  }
+
+  if ((in = fopen(argv[optind], "r")) == NULL)
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  if ((out = fopen(argv[optind+1], "wb")) == NULL)
+  {
+    perror(argv[optind+1]);
+    return 1;
+  }
+
+  // the header is rewritten with the final count at the end.
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, TRACE_MAGIC, 4);
+  hdr.version = TRACE_VERSION;
+  hdr.record_size = sizeof(struct trace_record);
+  hdr.period_ms = period_ms;
+  hdr.mote_id = mote_id;
+  fwrite(&hdr, sizeof(hdr), 1, out);
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    p = strstr(line, "Light: ");
+    if (p == NULL || (q = strstr(p, "Temp: ")) == NULL)
+      continue;
+    if (!parseTime(line, &time_ms))
+      time_ms = (uint32_t)(count * period_ms);
+    rec.time_ms = time_ms;
+    rec.light_adc = lightToADC(strtod(p+7, NULL));
+    rec.temp_adc = temperatureToADC(strtod(q+6, NULL));
+    fwrite(&rec, sizeof(rec), 1, out);
+    count++;
+  }
+
+  hdr.count = count;
+  fseek(out, 0, SEEK_SET);
+  fwrite(&hdr, sizeof(hdr), 1, out);
+  fclose(in);
+  if (fclose(out) != 0)
+  {
+    perror(argv[optind+1]);
+    return 1;
+  }
+  fprintf(stderr, "log2trace: %llu readings\n", (unsigned long long)count);
+  return 0;
+}
@@ -0,0 +1,680 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Serial Log Parser                                                               */
+/*                                                                                 */
+/* Reconstructs structured records from the human readable output of sensor.c and  */
+/* writes them as columns, one flat little-endian array per column:                */
+/*                                                                                 */
+/*   samples.{stream,light,temp}                       one row per "Light: ..."    */
+/*   reports.{stream,sample,heartbeat,stddev,count,    one row per Measurement     */
+/*            x0..,len0..}                             block or Heartbeat line     */
+/*   regressions.{stream,sample,heartbeat,slope,       one row per Regression      */
+/*                offset}                              block or Heartbeat line     */
+/*   drifts.{stream,sample,sign,estimate,sigma}        one row per "Drift: ..."    */
+/*   anomalies.{stream,sample,temp,light,estimate}     one row per "Anomaly: ..."  */
+/*   sampling.{stream,sample,intervals,mean,std,min,   one row per "Sampling: ..." */
+/*             max,overruns,missed}                                                */
+/*   jitter.{stream,sample,edge,count}                 one row per bin of a        */
+/*                                                     "Jitter: ..." line          */
+/*                                                                                 */
+/* stream and sample are int32 (the input file index and the index of the last     */
+/* reading before the line), and so are heartbeat (1 for a report or fit sent as   */
+/* unchanged, repeating the previous one), count (aggregated elements), len        */
+/* (readings per element), sign (+1 above, -1 below), intervals, overruns, missed  */
+/* and the jitter count; all other columns are float32, times in ms. There are     */
+/* WINDOW_LEN x and len columns, unused ones are NaN and 0; the jitter edge is the */
+/* upper edge of the bin, infinity for the last. A heartbeat report has no         */
+/* stddev (NaN). The B, T and EstT vectors of the blocks are not kept, they are    */
+/* the last readings of the samples table and the linear equation applied to them. */
+/* columns.txt lists the column types and row counts.                              */
+/*                                                                                 */
+/* Every input file is one mote stream. Files are mmap'd and scanned line by line  */
+/* with hand written number parsing, one file per core at a time.                  */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o logparse tools/logparse.c -lpthread                            */
+/*                                                                                 */
+/* Usage: logparse [-j threads] outdir log...                                      */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define X_MAX WINDOW_LEN // widest X[] vector the mote prints.
+
+struct column
+{
+  void *data;
+  size_t count, cap;
+};
+
+enum
+{
+  SAMPLES_STREAM, SAMPLES_LIGHT, SAMPLES_TEMP,
+  REPORTS_STREAM, REPORTS_SAMPLE, REPORTS_HEARTBEAT, REPORTS_STDDEV, REPORTS_COUNT,
+  REPORTS_X0, REPORTS_LEN0 = REPORTS_X0 + X_MAX,
+  REGRESSIONS_STREAM = REPORTS_LEN0 + X_MAX, REGRESSIONS_SAMPLE, REGRESSIONS_HEARTBEAT,
+  REGRESSIONS_SLOPE, REGRESSIONS_OFFSET,
+  DRIFTS_STREAM, DRIFTS_SAMPLE, DRIFTS_SIGN, DRIFTS_ESTIMATE, DRIFTS_SIGMA,
+  ANOMALIES_STREAM, ANOMALIES_SAMPLE, ANOMALIES_TEMP, ANOMALIES_LIGHT, ANOMALIES_ESTIMATE,
+  SAMPLING_STREAM, SAMPLING_SAMPLE, SAMPLING_INTERVALS, SAMPLING_MEAN, SAMPLING_STD,
+  SAMPLING_MIN, SAMPLING_MAX, SAMPLING_OVERRUNS, SAMPLING_MISSED,
+  JITTER_STREAM, JITTER_SAMPLE, JITTER_EDGE, JITTER_COUNT,
+  COLUMNS_COUNT
+};
+
+/* name and type of every column, filled by setupColumns(). */
+static char names[COLUMNS_COUNT][32];
+static unsigned char is_int[COLUMNS_COUNT];
+
+struct stream
+{
+  const char *path;
+  struct column col[COLUMNS_COUNT];
+  size_t bytes;
+  int ok;
+};
+
+static struct stream *streams;
+static int streams_count;
+static int next_stream; // next file to hand to a worker.
+static pthread_mutex_t next_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/***********************************************************************************/
+/* function to append a 4-byte value to a column */
+static void columnPush(struct column *c, const void *v)
+{
+  if (c->count == c->cap)
+  {
+    c->cap = c->cap ? 2*c->cap : 4096;
+    c->data = realloc(c->data, c->cap*4);
+    if (c->data == NULL)
+    {
+      fprintf(stderr, "logparse: out of memory\n");
+      exit(1);
+    }
+  }
+  memcpy((char *)c->data + c->count*4, v, 4);
+  c->count++;
+}
+
+static void pushInt(struct column *c, int32_t v)
+{
+  columnPush(c, &v);
+}
+
+static void pushFloat(struct column *c, float v)
+{
+  columnPush(c, &v);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to parse a number printed as "%d.%03u" by d1()/d2() */
+/* p is advanced past the number; returns 0 when there is none. */
+static int parseFixed(const char **pp, const char *end, float *v)
+{
+  const char *p = *pp;
+  long ip = 0, fp = 0;
+  int neg = 0, digits = 0;
+
+  if (p < end && *p == '-')
+  {
+    neg = 1;
+    p++;
+  }
+  while (p < end && *p >= '0' && *p <= '9')
+  {
+    ip = ip*10 + (*p++ - '0');
+    digits++;
+  }
+  if (digits == 0)
+    return 0;
+  if (p < end && *p == '.')
+  {
+    p++;
+    for (digits=0;digits<3 && p<end && *p>='0' && *p<='9';digits++)
+      fp = fp*10 + (*p++ - '0');
+    for (;digits<3;digits++)
+      fp *= 10;
+  }
+  *v = (float)ip + fp/1000.0f;
+  if (neg)
+    *v = -*v;
+  *pp = p;
+  return 1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to parse an unsigned decimal integer */
+/* p is advanced past the number; returns 0 when there is none. */
+static int parseCount(const char **pp, const char *end, int32_t *v)
+{
+  const char *p = *pp;
+  long n = 0;
+
+  if (p >= end || *p < '0' || *p > '9')
+    return 0;
+  while (p < end && *p >= '0' && *p <= '9')
+    n = n*10 + (*p++ - '0');
+  *v = (int32_t)n;
+  *pp = p;
+  return 1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to move p to just past the next occurrence of lit, before end */
+/* returns 0 when there is none. */
+static int skipPast(const char **pp, const char *end, const char *lit)
+{
+  size_t n = strlen(lit);
+  const char *p;
+
+  for (p=*pp;(size_t)(end-p) >= n;p++)
+  {
+    if (memcmp(p, lit, n) == 0)
+    {
+      *pp = p+n;
+      return 1;
+    }
+  }
+  return 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to parse "[a, b, ...]" into V, returns the element count */
+static int parseVector(const char *p, const char *end, float V[], int max)
+{
+  int n = 0;
+
+  p = memchr(p, '[', end-p);
+  if (p == NULL)
+    return 0;
+  p++;
+  while (n < max && p < end && *p != ']')
+  {
+    if (!parseFixed(&p, end, &V[n]))
+      break;
+    n++;
+    while (p < end && (*p == ',' || *p == ' '))
+      p++;
+  }
+  return n;
+}
+/***********************************************************************************/
+
+#define STARTS(p, end, lit) \
+  ((size_t)((end)-(p)) >= sizeof(lit)-1 && memcmp((p), (lit), sizeof(lit)-1) == 0)
+
+/***********************************************************************************/
+/* function to parse the segment lengths of an "Aggregation = " line into Len */
+/* "N-into-1" gives every element N readings. */
+static void parseAggregation(const char *p, const char *end, int32_t Len[])
+{
+  int32_t n;
+  int i = 0;
+
+  if (skipPast(&p, end, "Segment Lengths ="))
+  {
+    while (i < X_MAX && p < end && *p == ' ')
+    {
+      p++;
+      if (!parseCount(&p, end, &Len[i]))
+        break;
+      i++;
+    }
+  }
+  else
+  {
+    p += 14; // past "Aggregation = ".
+    if (!parseCount(&p, end, &n))
+      n = 0;
+    for (;i<X_MAX && n>0 && i*n<WINDOW_LEN;i++)
+      Len[i] = n;
+  }
+  for (;i<X_MAX;i++)
+    Len[i] = 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add one row to the reports table */
+static void pushReport(struct stream *st, int32_t id, int32_t sample, int heartbeat,
+                       float stddev, const float X[], const int32_t Len[], int n)
+{
+  int i;
+
+  pushInt(&st->col[REPORTS_STREAM], id);
+  pushInt(&st->col[REPORTS_SAMPLE], sample);
+  pushInt(&st->col[REPORTS_HEARTBEAT], heartbeat);
+  pushFloat(&st->col[REPORTS_STDDEV], stddev);
+  pushInt(&st->col[REPORTS_COUNT], n);
+  for (i=0;i<X_MAX;i++)
+    pushFloat(&st->col[REPORTS_X0+i], i < n ? X[i] : NAN);
+  for (i=0;i<X_MAX;i++)
+    pushInt(&st->col[REPORTS_LEN0+i], i < n ? Len[i] : 0);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to add one row to the regressions table */
+static void pushRegression(struct stream *st, int32_t id, int32_t sample, int heartbeat,
+                           float slope, float offset)
+{
+  pushInt(&st->col[REGRESSIONS_STREAM], id);
+  pushInt(&st->col[REGRESSIONS_SAMPLE], sample);
+  pushInt(&st->col[REGRESSIONS_HEARTBEAT], heartbeat);
+  pushFloat(&st->col[REGRESSIONS_SLOPE], slope);
+  pushFloat(&st->col[REGRESSIONS_OFFSET], offset);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to parse one mote stream */
+static void parseStream(struct stream *st, int32_t id, const char *p, const char *end)
+{
+  const char *eol, *q;
+  float light, temp, stddev = NAN, X[X_MAX], LastX[X_MAX];
+  float slope = NAN, offset, last_slope = NAN, last_offset = NAN;
+  float v[4];
+  int32_t Len[X_MAX], LastLen[X_MAX], c[3];
+  int32_t samples = 0;
+  int n, last_n = 0, i;
+
+  for (i=0;i<X_MAX;i++)
+    Len[i] = 0;
+
+  for (;p<end;p=eol+1)
+  {
+    eol = memchr(p, '\n', end-p);
+    if (eol == NULL)
+      eol = end;
+
+    // skip a Cooja log prefix ("time<TAB>ID:n<TAB>").
+    while (p < eol && ((*p >= '0' && *p <= '9') || STARTS(p, eol, "ID:")) &&
+           (q = memchr(p, '\t', eol-p)) != NULL)
+      p = q+1;
+
+    // logs from before the choice of regression methods say "Median Slope".
+    if (STARTS(p, eol, "Median "))
+      p += 7;
+
+    switch (p < eol ? *p : 0)
+    {
+      case 'L':
+        if (STARTS(p, eol, "Light: "))
+        {
+          q = p+7;
+          if (!parseFixed(&q, eol, &light))
+            break;
+          q = memchr(q, 'T', eol-q);
+          if (q == NULL || !STARTS(q, eol, "Temp: "))
+            break;
+          q += 6;
+          if (!parseFixed(&q, eol, &temp))
+            break;
+          pushInt(&st->col[SAMPLES_STREAM], id);
+          pushFloat(&st->col[SAMPLES_LIGHT], light);
+          pushFloat(&st->col[SAMPLES_TEMP], temp);
+          samples++;
+        }
+        break;
+
+      case 'S':
+        if (STARTS(p, eol, "StdDev = "))
+        {
+          q = p+9;
+          if (!parseFixed(&q, eol, &stddev))
+            stddev = NAN;
+        }
+        else if (STARTS(p, eol, "Slope: "))
+        {
+          q = p+7;
+          if (!parseFixed(&q, eol, &slope))
+            slope = NAN;
+        }
+        else if (STARTS(p, eol, "Sampling: "))
+        {
+          // "Sampling: n intervals, spacing m ms +- s ms, min a ms, max b ms,
+          // o overruns, k missed"
+          q = p+10;
+          if (!parseCount(&q, eol, &c[0]) ||
+              !skipPast(&q, eol, "spacing ") || !parseFixed(&q, eol, &v[0]) ||
+              !skipPast(&q, eol, "+- ") || !parseFixed(&q, eol, &v[1]) ||
+              !skipPast(&q, eol, "min ") || !parseFixed(&q, eol, &v[2]) ||
+              !skipPast(&q, eol, "max ") || !parseFixed(&q, eol, &v[3]) ||
+              !skipPast(&q, eol, "ms, ") || !parseCount(&q, eol, &c[1]) ||
+              !skipPast(&q, eol, "overruns, ") || !parseCount(&q, eol, &c[2]))
+            break;
+          pushInt(&st->col[SAMPLING_STREAM], id);
+          pushInt(&st->col[SAMPLING_SAMPLE], samples-1);
+          pushInt(&st->col[SAMPLING_INTERVALS], c[0]);
+          for (i=0;i<4;i++)
+            pushFloat(&st->col[SAMPLING_MEAN+i], v[i]);
+          pushInt(&st->col[SAMPLING_OVERRUNS], c[1]);
+          pushInt(&st->col[SAMPLING_MISSED], c[2]);
+        }
+        break;
+
+      case 'A':
+        if (STARTS(p, eol, "Aggregation = "))
+        {
+          parseAggregation(p, eol, Len);
+        }
+        else if (STARTS(p, eol, "Anomaly: Temp "))
+        {
+          // "Anomaly: Temp t C at l lx, estimated e C"
+          q = p+14;
+          if (!parseFixed(&q, eol, &v[0]) ||
+              !skipPast(&q, eol, "at ") || !parseFixed(&q, eol, &v[1]) ||
+              !skipPast(&q, eol, "estimated ") || !parseFixed(&q, eol, &v[2]))
+            break;
+          pushInt(&st->col[ANOMALIES_STREAM], id);
+          pushInt(&st->col[ANOMALIES_SAMPLE], samples-1);
+          for (i=0;i<3;i++)
+            pushFloat(&st->col[ANOMALIES_TEMP+i], v[i]);
+        }
+        break;
+
+      case 'D':
+        if (STARTS(p, eol, "Drift: Temp "))
+        {
+          // "Drift: Temp above|below the estimate of e C +- s C"
+          q = p+12;
+          c[0] = STARTS(q, eol, "above") ? 1 : -1;
+          if (!skipPast(&q, eol, "of ") || !parseFixed(&q, eol, &v[0]) ||
+              !skipPast(&q, eol, "+- ") || !parseFixed(&q, eol, &v[1]))
+            break;
+          pushInt(&st->col[DRIFTS_STREAM], id);
+          pushInt(&st->col[DRIFTS_SAMPLE], samples-1);
+          pushInt(&st->col[DRIFTS_SIGN], c[0]);
+          pushFloat(&st->col[DRIFTS_ESTIMATE], v[0]);
+          pushFloat(&st->col[DRIFTS_SIGMA], v[1]);
+        }
+        break;
+
+      case 'J':
+        if (STARTS(p, eol, "Jitter:"))
+        {
+          // "Jitter: <e ms n, <e ms n, ... more n", non-empty bins only.
+          q = p+7;
+          while (skipPast(&q, eol, " <"))
+          {
+            if (!parseFixed(&q, eol, &v[0]) || !skipPast(&q, eol, "ms ") ||
+                !parseCount(&q, eol, &c[0]))
+              break;
+            pushInt(&st->col[JITTER_STREAM], id);
+            pushInt(&st->col[JITTER_SAMPLE], samples-1);
+            pushFloat(&st->col[JITTER_EDGE], v[0]);
+            pushInt(&st->col[JITTER_COUNT], c[0]);
+          }
+          if (skipPast(&q, eol, "more ") && parseCount(&q, eol, &c[0]))
+          {
+            pushInt(&st->col[JITTER_STREAM], id);
+            pushInt(&st->col[JITTER_SAMPLE], samples-1);
+            pushFloat(&st->col[JITTER_EDGE], INFINITY);
+            pushInt(&st->col[JITTER_COUNT], c[0]);
+          }
+        }
+        break;
+
+      case 'H':
+        // a suppressed report or fit repeats the previous one.
+        if (STARTS(p, eol, "Heartbeat: Measurement"))
+          pushReport(st, id, samples-1, 1, NAN, LastX, LastLen, last_n);
+        else if (STARTS(p, eol, "Heartbeat: Regression"))
+          pushRegression(st, id, samples-1, 1, last_slope, last_offset);
+        break;
+
+      case 'X':
+        if (STARTS(p, eol, "X = ["))
+        {
+          n = parseVector(p, eol, X, X_MAX);
+          pushReport(st, id, samples-1, 0, stddev, X, Len, n);
+          memcpy(LastX, X, sizeof(X));
+          memcpy(LastLen, Len, sizeof(Len));
+          last_n = n;
+          stddev = NAN;
+        }
+        break;
+
+      case 'O':
+        if (STARTS(p, eol, "Offset: "))
+        {
+          q = p+8;
+          if (!parseFixed(&q, eol, &offset))
+            break;
+          pushRegression(st, id, samples-1, 0, slope, offset);
+          last_slope = slope;
+          last_offset = offset;
+          slope = NAN;
+        }
+        break;
+    }
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function run by every worker: map and parse files until none are left */
+static void *parseWorker(void *arg)
+{
+  struct stream *st;
+  struct stat sb;
+  void *map;
+  int fd, id;
+
+  (void)arg;
+  for (;;)
+  {
+    pthread_mutex_lock(&next_lock);
+    id = next_stream++;
+    pthread_mutex_unlock(&next_lock);
+    if (id >= streams_count)
+      return NULL;
+    st = &streams[id];
+
+    if ((fd = open(st->path, O_RDONLY)) < 0 || fstat(fd, &sb) != 0)
+    {
+      perror(st->path);
+      if (fd >= 0)
+        close(fd);
+      continue;
+    }
+    st->ok = 1;
+    st->bytes = sb.st_size;
+    if (sb.st_size == 0)
+    {
+      close(fd);
+      continue;
+    }
+    map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+      perror(st->path);
+      st->ok = 0;
+      continue;
+    }
+    madvise(map, sb.st_size, MADV_SEQUENTIAL);
+    parseStream(st, id, map, (const char *)map + sb.st_size);
+    munmap(map, sb.st_size);
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to write one column of all streams, in stream order */
+static int writeColumn(const char *dir, const char *name, int c, size_t *rows)
+{
+  char path[4096];
+  FILE *f;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  if ((f = fopen(path, "wb")) == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  *rows = 0;
+  for (i=0;i<streams_count;i++)
+  {
+    fwrite(streams[i].col[c].data, 4, streams[i].col[c].count, f);
+    *rows += streams[i].col[c].count;
+  }
+  if (fclose(f) != 0)
+  {
+    perror(path);
+    return -1;
+  }
+  return 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to name the columns and mark the int32 ones */
+static void setupColumns(void)
+{
+  static const char *fixed[COLUMNS_COUNT] = {
+    [SAMPLES_STREAM] = "samples.stream", [SAMPLES_LIGHT] = "samples.light",
+    [SAMPLES_TEMP] = "samples.temp",
+    [REPORTS_STREAM] = "reports.stream", [REPORTS_SAMPLE] = "reports.sample",
+    [REPORTS_HEARTBEAT] = "reports.heartbeat", [REPORTS_STDDEV] = "reports.stddev",
+    [REPORTS_COUNT] = "reports.count",
+    [REGRESSIONS_STREAM] = "regressions.stream", [REGRESSIONS_SAMPLE] = "regressions.sample",
+    [REGRESSIONS_HEARTBEAT] = "regressions.heartbeat",
+    [REGRESSIONS_SLOPE] = "regressions.slope", [REGRESSIONS_OFFSET] = "regressions.offset",
+    [DRIFTS_STREAM] = "drifts.stream", [DRIFTS_SAMPLE] = "drifts.sample",
+    [DRIFTS_SIGN] = "drifts.sign", [DRIFTS_ESTIMATE] = "drifts.estimate",
+    [DRIFTS_SIGMA] = "drifts.sigma",
+    [ANOMALIES_STREAM] = "anomalies.stream", [ANOMALIES_SAMPLE] = "anomalies.sample",
+    [ANOMALIES_TEMP] = "anomalies.temp", [ANOMALIES_LIGHT] = "anomalies.light",
+    [ANOMALIES_ESTIMATE] = "anomalies.estimate",
+    [SAMPLING_STREAM] = "sampling.stream", [SAMPLING_SAMPLE] = "sampling.sample",
+    [SAMPLING_INTERVALS] = "sampling.intervals", [SAMPLING_MEAN] = "sampling.mean",
+    [SAMPLING_STD] = "sampling.std", [SAMPLING_MIN] = "sampling.min",
+    [SAMPLING_MAX] = "sampling.max", [SAMPLING_OVERRUNS] = "sampling.overruns",
+    [SAMPLING_MISSED] = "sampling.missed",
+    [JITTER_STREAM] = "jitter.stream", [JITTER_SAMPLE] = "jitter.sample",
+    [JITTER_EDGE] = "jitter.edge", [JITTER_COUNT] = "jitter.count",
+  };
+  static const int ints[] = {
+    SAMPLES_STREAM, REPORTS_STREAM, REPORTS_SAMPLE, REPORTS_HEARTBEAT, REPORTS_COUNT,
+    REGRESSIONS_STREAM, REGRESSIONS_SAMPLE, REGRESSIONS_HEARTBEAT,
+    DRIFTS_STREAM, DRIFTS_SAMPLE, DRIFTS_SIGN, ANOMALIES_STREAM, ANOMALIES_SAMPLE,
+    SAMPLING_STREAM, SAMPLING_SAMPLE, SAMPLING_INTERVALS, SAMPLING_OVERRUNS,
+    SAMPLING_MISSED, JITTER_STREAM, JITTER_SAMPLE, JITTER_COUNT,
+  };
+  int c, i;
+
+  for (c=0;c<COLUMNS_COUNT;c++)
+  {
+    if (fixed[c] != NULL)
+      snprintf(names[c], sizeof(names[c]), "%s", fixed[c]);
+  }
+  for (i=0;i<X_MAX;i++)
+  {
+    snprintf(names[REPORTS_X0+i], sizeof(names[0]), "reports.x%d", i);
+    snprintf(names[REPORTS_LEN0+i], sizeof(names[0]), "reports.len%d", i);
+    is_int[REPORTS_LEN0+i] = 1;
+  }
+  for (i=0;i<(int)(sizeof(ints)/sizeof(ints[0]));i++)
+    is_int[ints[i]] = 1;
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  pthread_t *threads;
+  char path[4096];
+  struct timespec t0, t1;
+  double elapsed, bytes = 0;
+  size_t rows = 0;
+  FILE *f;
+  int threads_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int opt, i, c, failed = 0;
+
+  while ((opt = getopt(argc, argv, "j:")) != -1)
+  {
+    if (opt != 'j')
+    {
+      fprintf(stderr, "usage: %s [-j threads] outdir log...\n", argv[0]);
+      return 2;
+    }
+    threads_count = atoi(optarg);
+  }
+  if (argc-optind < 2)
+  {
+    fprintf(stderr, "usage: %s [-j threads] outdir log...\n", argv[0]);
+    return 2;
+  }
+  if (mkdir(argv[optind], 0777) != 0 && errno != EEXIST)
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  streams_count = argc-optind-1;
+  streams = calloc(streams_count, sizeof(*streams));
+  for (i=0;i<streams_count;i++)
+    streams[i].path = argv[optind+1+i];
+  if (threads_count > streams_count)
+    threads_count = streams_count;
+  if (threads_count < 1)
+    threads_count = 1;
+
+  setupColumns();
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  threads = calloc(threads_count, sizeof(*threads));
+  for (i=0;i<threads_count;i++)
+    pthread_create(&threads[i], NULL, parseWorker, NULL);
+  for (i=0;i<threads_count;i++)
+    pthread_join(threads[i], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  snprintf(path, sizeof(path), "%s/columns.txt", argv[optind]);
+  if ((f = fopen(path, "w")) == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+  for (c=0;c<COLUMNS_COUNT;c++)
+  {
+    if (writeColumn(argv[optind], names[c], c, &rows) != 0)
+      failed = 1;
+    fprintf(f, "%s %s %zu\n", names[c], is_int[c] ? "int32" : "float32", rows);
+  }
+  fclose(f);
+
+  for (i=0;i<streams_count;i++)
+  {
+    if (!streams[i].ok)
+      failed = 1;
+    bytes += streams[i].bytes;
+    for (c=0;c<COLUMNS_COUNT;c++)
+      free(streams[i].col[c].data);
+  }
+  elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+  fprintf(stderr, "logparse: %d streams, %.1f MB on %d threads in %.3f s (%.0f MB/s)\n",
+          streams_count, bytes/1e6, threads_count, elapsed,
+          elapsed > 0 ? bytes/1e6/elapsed : 0);
+
+  free(threads);
+  free(streams);
+  return failed;
+}
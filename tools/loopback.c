@@ -0,0 +1,240 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Loopback Radio                                                                  */
+/*                                                                                 */
+/* Stand-in for the Rime link between the sensor motes and the sink, to test the   */
+/* transport on Linux without Cooja. Several motes run the pipeline, codec and     */
+/* transport of sensor.c over a recorded trace (each starting at its own offset);  */
+/* every packet they send is handed straight to the sink of sink.c, or dropped     */
+/* with the given probability. Every report the sink decodes is checked against    */
+/* what the mote encoded.                                                          */
+/*                                                                                 */
+/* One line per batch size: packets, payload bytes, bytes on air per report (the   */
+/* payload plus the per-packet cost of 802.15.4: 6 PHY, 9 MAC header, 2 FCS bytes  */
+/* and an 11-byte ACK, changed with -a), and reports delivered, lost with their    */
+/* packet, or dropped by the sink while waiting for a key frame.                   */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o loopback tools/loopback.c tools/trace.c transport.c \          */
+/*       report-codec.c sensor-proc.c                                              */
+/*                                                                                 */
+/* Usage: loopback [-n motes] [-b batch] [-l loss %] [-a air overhead] trace       */
+/*   without -b every batch size from 1 to TRANSPORT_BATCH is run.                 */
+/*   trace is a binary trace (tools/trace-format.h) or text with the mote's        */
+/*   "Light: x lx, Temp: y C" lines or plain "light,temp" CSV.                     */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include "report-codec.h"
+#include "transport.h"
+#include "tools/trace.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+struct mote
+{
+  unsigned int id;
+  struct sensor_pipeline pipeline;
+  struct report_codec codec;
+  struct transport transport;
+  long pending[TRANSPORT_BATCH+1][WINDOW_LEN]; // reports of the unsent packet.
+  int pending_count[TRANSPORT_BATCH+1];
+  int pending_n;
+};
+
+struct run_stats
+{
+  unsigned long reports, delivered, in_lost_packets, mismatches;
+};
+
+static struct trace trace;
+
+static struct transport_sink sink;
+static struct run_stats run;
+static long decoded[TRANSPORT_BATCH][WINDOW_LEN]; // reports of the packet at the sink.
+static int decoded_count[TRANSPORT_BATCH];
+static int decoded_n;
+static int loss_percent;
+static uint32_t rng = 2463534242u;
+
+/***********************************************************************************/
+/* function called by the sink for every decoded report */
+static void collectReport(unsigned int id, const long X[], int AggrElementsCount, void *ctx)
+{
+  (void)id;
+  (void)ctx;
+  memcpy(decoded[decoded_n], X, AggrElementsCount*sizeof(long));
+  decoded_count[decoded_n] = AggrElementsCount;
+  decoded_n++;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function standing in for the radio, called by transport.c */
+/* the reports a packet carries are the oldest pending ones of the mote; the */
+/* ones the sink decodes are the last of them (it only skips the reports */
+/* before a key frame). */
+static void sendPacket(const unsigned char *buf, int len, void *ctx)
+{
+  struct mote *m = ctx;
+  int count = buf[0] & 0x0f, first, i;
+
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+
+  decoded_n = 0;
+  if ((int)(rng % 100) < loss_percent)
+    run.in_lost_packets += count;
+  else if (sinkReceive(&sink, m->id, buf, len) < 0)
+    run.mismatches += count;
+
+  first = count - decoded_n;
+  for (i=0;i<decoded_n;i++)
+  {
+    if (decoded_count[i] != m->pending_count[first+i] ||
+        memcmp(decoded[i], m->pending[first+i], decoded_count[i]*sizeof(long)) != 0)
+      run.mismatches++;
+  }
+  run.delivered += decoded_n;
+
+  m->pending_n -= count;
+  memmove(m->pending, m->pending[count], m->pending_n*sizeof(m->pending[0]));
+  memmove(m->pending_count, m->pending_count+count, m->pending_n*sizeof(int));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to run all motes over the trace with the given batch size */
+static void runMotes(struct mote *motes, int motes_count, int batch)
+{
+  unsigned char Enc[CODEC_MAX_BYTES];
+  float X[WINDOW_LEN];
+  struct mote *m;
+  long s;
+  int EncLen, i, j, k, l;
+
+  memset(&run, 0, sizeof(run));
+  sinkInit(&sink, collectReport, NULL);
+  for (i=0;i<motes_count;i++)
+  {
+    m = &motes[i];
+    memset(m, 0, sizeof(*m));
+    m->id = i+1;
+    pipelineInit(&m->pipeline);
+    codecInit(&m->codec);
+    transportInit(&m->transport, batch, sendPacket, m);
+  }
+
+  for (s=0;s<trace.count;s++)
+  {
+    for (i=0;i<motes_count;i++)
+    {
+      m = &motes[i];
+      j = (int)((s + i*(trace.count/motes_count)) % trace.count);
+      if (!(pipelineAddSample(&m->pipeline, trace.light[j], trace.temp[j]) & PIPELINE_MEASURE))
+        continue;
+      pipelineMeasure(&m->pipeline, X);
+      if (m->pipeline.tolerance > 0)
+      {
+        // segments reach the sink as the readings they stand for.
+        EncLen = codecEncodeSegments(&m->codec, X, m->pipeline.SegmentLen,
+                                     m->pipeline.AggrElementsCount, Enc);
+        for (j=0,k=0;j<m->pipeline.AggrElementsCount;j++)
+        {
+          for (l=0;l<m->pipeline.SegmentLen[j];l++)
+            m->pending[m->pending_n][k++] = codecQuantize(X[j]);
+        }
+        m->pending_count[m->pending_n++] = WINDOW_LEN;
+      }
+      else
+      {
+        EncLen = codecEncode(&m->codec, X, m->pipeline.AggrElementsCount, Enc);
+        for (j=0;j<m->pipeline.AggrElementsCount;j++)
+          m->pending[m->pending_n][j] = codecQuantize(X[j]);
+        m->pending_count[m->pending_n++] = m->pipeline.AggrElementsCount;
+      }
+      run.reports++;
+      transportAddReport(&m->transport, Enc, EncLen);
+    }
+  }
+  for (i=0;i<motes_count;i++)
+    transportFlush(&motes[i].transport);
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  struct mote *motes;
+  unsigned long packets, bytes, undecodable;
+  int motes_count = 4, batch = 0, air_overhead = 6+9+2+11;
+  int opt, b, i;
+
+  while ((opt = getopt(argc, argv, "n:b:l:a:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        motes_count = atoi(optarg);
+        break;
+      case 'b':
+        batch = atoi(optarg);
+        break;
+      case 'l':
+        loss_percent = atoi(optarg);
+        break;
+      case 'a':
+        air_overhead = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n motes] [-b batch] [-l loss %%] [-a air overhead] trace\n",
+                argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc-1)
+  {
+    fprintf(stderr, "usage: %s [-n motes] [-b batch] [-l loss %%] [-a air overhead] trace\n",
+            argv[0]);
+    return 2;
+  }
+  if (motes_count < 1 || motes_count > SINK_SOURCES)
+  {
+    fprintf(stderr, "loopback: 1 to %d motes\n", SINK_SOURCES);
+    return 2;
+  }
+  if (traceLoad(argv[optind], &trace) != 0)
+    return 1;
+  if (trace.count == 0)
+  {
+    fprintf(stderr, "loopback: empty trace\n");
+    return 1;
+  }
+
+  motes = calloc(motes_count, sizeof(*motes));
+  printf("batch  packets  payload bytes  air bytes/report  reports  delivered  lost"
+         "  undecodable  mismatches\n");
+  for (b=(batch ? batch : 1);b<=(batch ? batch : TRANSPORT_BATCH);b++)
+  {
+    runMotes(motes, motes_count, b);
+
+    packets = bytes = undecodable = 0;
+    for (i=0;i<motes_count;i++)
+    {
+      packets += motes[i].transport.packets;
+      bytes += motes[i].transport.bytes;
+    }
+    for (i=0;i<SINK_SOURCES;i++)
+      undecodable += sink.src[i].undecodable;
+    printf("%5d %8lu %14lu %17.2f %8lu %10lu %5lu %12lu %11lu\n", b, packets, bytes,
+           (double)(bytes + packets*air_overhead) / run.reports, run.reports,
+           run.delivered, run.in_lost_packets, undecodable, run.mismatches);
+  }
+  free(motes);
+  traceClose(&trace);
+  return run.mismatches != 0;
+}
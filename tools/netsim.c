@@ -0,0 +1,207 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Collection Tree Simulator                                                       */
+/*                                                                                 */
+/* Simulates the in-network rollups of rollup.h on a complete tree: the sink at    */
+/* the root, relay nodes (relay.c) at the inner levels and sensor motes (sensor.c  */
+/* with SENSOR_CONF_ROLLUP 1) at the leaves, every node with the same fan-out.     */
+/* Each mote reads a recorded trace from its own offset; every reporting period    */
+/* each mote packs the summary of its newest readings for its parent, each relay   */
+/* unpacks and merges what its children sent and packs one summary for its parent. */
+/*                                                                                 */
+/* Reported: packets and bytes over all links per period, against forwarding every */
+/* mote summary unmerged to the sink, and the error of the sink's summary against  */
+/* the exact statistics of all readings of the period (mean and std-dev relative   */
+/* to the std-dev, quantiles relative to their value).                             */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o netsim tools/netsim.c tools/trace.c rollup.c report-codec.c \  */
+/*       sensor-proc.c -lm                                                         */
+/*                                                                                 */
+/* Usage: netsim [-f fan-out] [-d depth] trace                                     */
+/*   depth counts the links from a mote to the sink; there are fan-out^depth       */
+/*   motes.                                                                        */
+/*   trace is a binary trace (tools/trace-format.h) or text with the mote's        */
+/*   "Light: x lx, Temp: y C" lines or plain "light,temp" CSV.                     */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include "rollup.h"
+#include "tools/trace.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static struct trace trace;
+
+/***********************************************************************************/
+/* function to compare floats for qsort() */
+static int compareFloats(const void *a, const void *b)
+{
+  float x = *(const float *)a, y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to send a summary over one link: pack, count, unpack */
+/* returns the packed length. */
+static int sendOverLink(const struct rollup *r, struct rollup *received,
+                         unsigned long *packets, unsigned long *bytes)
+{
+  unsigned char buf[ROLLUP_MAX_BYTES];
+  int len;
+
+  len = rollupPack(r, buf);
+  if (rollupUnpack(received, buf, len) != len)
+  {
+    fprintf(stderr, "netsim: summary does not unpack\n");
+    exit(1);
+  }
+  (*packets)++;
+  *bytes += len;
+  return len;
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  struct sensor_pipeline *pipelines;
+  struct rollup *level, *next, received;
+  float *readings;
+  unsigned long packets = 0, bytes = 0, fwd_packets = 0, fwd_bytes = 0, periods = 0;
+  double sum, ssd, mean, std, q, err, err_mean = 0, err_std = 0, err_q[2] = {0, 0};
+  double max_mean = 0, max_std = 0, max_q[2] = {0, 0};
+  long motes_count = 1, s, p, j;
+  int fanout = 4, depth = 3, opt, len, d, i, k;
+  const float Q[2] = {0.5f, 0.9f};
+
+  while ((opt = getopt(argc, argv, "f:d:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'f':
+        fanout = atoi(optarg);
+        break;
+      case 'd':
+        depth = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-f fan-out] [-d depth] trace\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc-1 || fanout < 1 || depth < 1)
+  {
+    fprintf(stderr, "usage: %s [-f fan-out] [-d depth] trace\n", argv[0]);
+    return 2;
+  }
+  for (d=0;d<depth;d++)
+    motes_count *= fanout;
+  if (traceLoad(argv[optind], &trace) != 0)
+    return 1;
+  if (trace.count < REPORT_FREQ)
+  {
+    fprintf(stderr, "netsim: trace too short\n");
+    return 1;
+  }
+
+  pipelines = calloc(motes_count, sizeof(*pipelines));
+  level = calloc(motes_count, sizeof(*level));
+  next = calloc(motes_count, sizeof(*next));
+  readings = calloc(motes_count*REPORT_FREQ, sizeof(float));
+  for (i=0;i<motes_count;i++)
+    pipelineInit(&pipelines[i]);
+
+  for (s=0;s+REPORT_FREQ<=trace.count;s+=REPORT_FREQ)
+  {
+    // motes: REPORT_FREQ readings, then the summary of the newest ones.
+    for (i=0;i<motes_count;i++)
+    {
+      for (k=0;k<REPORT_FREQ;k++)
+      {
+        j = (s + k + i*(trace.count/motes_count)) % trace.count;
+        pipelineAddSample(&pipelines[i], trace.light[j], trace.temp[j]);
+      }
+      rollupInit(&level[i]);
+      rollupAddWindow(&level[i], pipelines[i].B + WINDOW_LEN-REPORT_FREQ, REPORT_FREQ);
+      memcpy(readings + i*REPORT_FREQ, pipelines[i].B + WINDOW_LEN-REPORT_FREQ,
+             REPORT_FREQ*sizeof(float));
+
+      // forwarding without merging: the same summary over every hop.
+      len = sendOverLink(&level[i], &received, &fwd_packets, &fwd_bytes);
+      fwd_packets += depth-1;
+      fwd_bytes += (unsigned long)(depth-1) * len;
+    }
+
+    // one level up per step, merging fan-out children into each parent.
+    for (p=motes_count, d=depth;d>0;d--, p/=fanout)
+    {
+      for (i=0;i<p/fanout;i++)
+        rollupInit(&next[i]);
+      for (i=0;i<p;i++)
+      {
+        sendOverLink(&level[i], &received, &packets, &bytes);
+        rollupMerge(&next[i/fanout], &received);
+      }
+      memcpy(level, next, (p/fanout)*sizeof(*level));
+    }
+
+    // exact statistics of the period.
+    sum = ssd = 0;
+    for (i=0;i<motes_count*REPORT_FREQ;i++)
+      sum += readings[i];
+    mean = sum / (motes_count*REPORT_FREQ);
+    for (i=0;i<motes_count*REPORT_FREQ;i++)
+      ssd += (readings[i]-mean) * (readings[i]-mean);
+    std = sqrt(ssd / (motes_count*REPORT_FREQ));
+    qsort(readings, motes_count*REPORT_FREQ, sizeof(float), compareFloats);
+
+    if (std > 0)
+    {
+      err = fabs(level[0].stats.mean - mean) / std;
+      err_mean += err;
+      max_mean = err > max_mean ? err : max_mean;
+      err = fabs(statsStdDev(&level[0].stats) - std) / std;
+      err_std += err;
+      max_std = err > max_std ? err : max_std;
+    }
+    for (k=0;k<2;k++)
+    {
+      q = readings[(long)(Q[k]*(motes_count*REPORT_FREQ-1))];
+      err = q > 0 ? fabs(rollupQuantile(&level[0], Q[k]) - q) / q : 0;
+      err_q[k] += err;
+      max_q[k] = err > max_q[k] ? err : max_q[k];
+    }
+    if (level[0].stats.count != (unsigned long)motes_count*REPORT_FREQ ||
+        level[0].motes != (unsigned long)motes_count)
+    {
+      fprintf(stderr, "netsim: readings lost in the tree\n");
+      return 1;
+    }
+    periods++;
+  }
+
+  printf("%ld motes, fan-out %d, depth %d, %lu periods\n", motes_count, fanout, depth,
+         periods);
+  printf("forwarded: %.1f packets %.0f bytes per period\n",
+         (double)fwd_packets/periods, (double)fwd_bytes/periods);
+  printf("merged:    %.1f packets %.0f bytes per period (%.1fx fewer packets,"
+         " %.1fx fewer bytes)\n", (double)packets/periods, (double)bytes/periods,
+         (double)fwd_packets/packets, (double)fwd_bytes/bytes);
+  printf("sink error, mean (max): mean %.2g (%.2g) std, std-dev %.2g (%.2g),"
+         " median %.3f (%.3f), p90 %.3f (%.3f)\n",
+         err_mean/periods, max_mean, err_std/periods, max_std,
+         err_q[0]/periods, max_q[0], err_q[1]/periods, max_q[1]);
+
+  free(pipelines);
+  free(level);
+  free(next);
+  free(readings);
+  traceClose(&trace);
+  return 0;
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+#####################################################################################
+#                                                                                   #
+# RAM usage report for the sensor firmware                                          #
+#                                                                                   #
+# Lists every statically allocated symbol (.data and .bss) of the linked firmware   #
+# with its size, largest first, followed by the total against the RAM of the mote.  #
+# Exits non-zero when the static RAM exceeds the budget, so it can run as the last  #
+# step of the build:                                                                #
+#                                                                                   #
+#   make TARGET=sky sensor && tools/ram-report.sh sensor.sky                        #
+#                                                                                   #
+# Environment:                                                                      #
+#   NM        nm of the toolchain (default msp430-nm)                               #
+#   RAM_SIZE  RAM of the mote in bytes (default 10240, MSP430F1611 on Sky)          #
+#                                                                                   #
+#####################################################################################
+
+if [ $# -ne 1 ]; then
+  echo "usage: $0 <firmware elf>" >&2
+  exit 2
+fi
+
+NM=${NM:-msp430-nm}
+RAM_SIZE=${RAM_SIZE:-10240}
+
+$NM -S --size-sort -r "$1" | awk -v ram="$RAM_SIZE" '
+  function hex(s,    i, n) {
+    n = 0
+    for (i = 1; i <= length(s); i++)
+      n = n * 16 + index("0123456789abcdef", tolower(substr(s, i, 1))) - 1
+    return n
+  }
+  # only sized symbols in .data (d/D) and .bss (b/B) take RAM.
+  NF == 4 && $3 ~ /^[bBdD]$/ {
+    size = hex($2)
+    total += size
+    printf "%6d  %s  %s\n", size, ($3 ~ /[dD]/ ? "data" : "bss "), $4
+  }
+  END {
+    printf "------\n%6d  bytes of static RAM, %d bytes left for stack and heap\n",
+           total, ram - total
+    if (total > ram) exit 1
+  }'
@@ -0,0 +1,233 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Regression Benchmark                                                            */
+/*                                                                                 */
+/* Cost against robustness of the regression methods of sensor-proc.h. The light   */
+/* readings of a recorded trace are paired with temperatures on a known line,      */
+/* T = 20 C + 0.004 C/lx * light, plus gaussian noise and a share of outliers      */
+/* (readings off by a fixed spike, either sign), then every WINDOW_LEN-reading     */
+/* window is fit by each method as the mote fits it. Reported per method: time per */
+/* fit on the host, and the error of the fitted line against the true one at the   */
+/* readings of the window (median and 95th percentile of the window RMS), and how  */
+/* the anomaly detection on its residuals does: the share of outliers flagged and  */
+/* the readings flagged that were not outliers, per window.                        */
+/* The online tracker of sensor-proc.h runs over the same readings: time per       */
+/* reading, RMS of its per-reading estimate against the true line, false drift     */
+/* alarms, and, with the true offset drifting from half of the trace on, how many  */
+/* readings it takes to raise the alarm.                                           */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o regress tools/regress.c tools/trace.c sensor-proc.c -lm        */
+/*                                                                                 */
+/* Usage: regress [-n noise C] [-p outliers %] [-s spike C] [-d drift C] trace     */
+/*   defaults: 0.05 C noise, 5% outliers of 5 C, a drift of 0.01 C per reading.    */
+/*   trace is a binary trace (tools/trace-format.h) or text with the mote's        */
+/*   "Light: x lx, Temp: y C" lines or plain "light,temp" CSV.                     */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include "tools/trace.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define METHODS 4
+
+#define TRUE_OFFSET 20.0f  // C.
+#define TRUE_SLOPE 0.004f  // C per lx.
+
+static struct trace trace;
+
+/***********************************************************************************/
+/* function to draw a standard normal number (Box-Muller) */
+static float gaussian(void)
+{
+  double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = rand() / (RAND_MAX + 1.0);
+
+  return (float)(sqrt(-2*log(u)) * cos(2*M_PI*v));
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to compare floats for qsort() */
+static int compareFloats(const void *a, const void *b)
+{
+  float x = *(const float *)a, y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  long arena_mem[(ARENA_MAX(REGRESS_MAX_SCRATCH_SIZE, ANOMALY_SCRATCH_SIZE) +
+                 sizeof(long)-1) / sizeof(long)];
+  struct arena scratch;
+  struct regression fit;
+  struct timespec t0, t1;
+  struct tracker tracker;
+  float noise = 0.05f, outliers = 5, spike = 5, drift = 0.01f;
+  float *T, *rms, d, ssd, EstT[WINDOW_LEN];
+  short *QB, *QT;
+  unsigned char *spiked, Index[WINDOW_LEN];
+  long spikes, found, wrong;
+  double ns;
+  long windows, w, alarms, delay;
+  int method, opt, i, n;
+
+  while ((opt = getopt(argc, argv, "n:p:s:d:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        noise = atof(optarg);
+        break;
+      case 'p':
+        outliers = atof(optarg);
+        break;
+      case 's':
+        spike = atof(optarg);
+        break;
+      case 'd':
+        drift = atof(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n noise C] [-p outliers %%] [-s spike C] [-d drift C]"
+                " trace\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc-1)
+  {
+    fprintf(stderr, "usage: %s [-n noise C] [-p outliers %%] [-s spike C] [-d drift C]"
+            " trace\n", argv[0]);
+    return 2;
+  }
+  if (traceLoad(argv[optind], &trace) != 0)
+    return 1;
+  windows = trace.count / WINDOW_LEN;
+  if (windows == 0)
+  {
+    fprintf(stderr, "regress: trace too short\n");
+    return 1;
+  }
+
+  // the measured temperatures, the same for every method.
+  srand(1);
+  T = malloc(windows*WINDOW_LEN*sizeof(float));
+  rms = malloc(windows*sizeof(float));
+  spiked = calloc(windows*WINDOW_LEN, 1);
+  spikes = 0;
+  for (i=0;i<windows*WINDOW_LEN;i++)
+  {
+    T[i] = TRUE_OFFSET + TRUE_SLOPE*trace.light[i] + noise*gaussian();
+    if (rand() < outliers/100 * RAND_MAX)
+    {
+      T[i] += rand() & 1 ? spike : -spike;
+      spiked[i] = 1;
+      spikes++;
+    }
+  }
+
+  // the readings in sensor steps, rounded once per reading as the pipeline does.
+  QB = malloc(windows*WINDOW_LEN*sizeof(short));
+  QT = malloc(windows*WINDOW_LEN*sizeof(short));
+  for (i=0;i<windows*WINDOW_LEN;i++)
+  {
+    QB[i] = getSteps(trace.light[i], 1/LIGHT_STEP);
+    QT[i] = getSteps(T[i], 1/TEMP_STEP);
+  }
+  arenaInit(&scratch, arena_mem, sizeof(arena_mem));
+
+  printf("%ld windows, noise %.3f C, %.1f%% outliers of %.1f C\n", windows, noise,
+         outliers, spike);
+  printf("method                   ns/fit  median rms C  p95 rms C  flagged %%  false/window\n");
+  for (method=0;method<METHODS;method++)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (w=0;w<windows;w++)
+      regress(trace.light + w*WINDOW_LEN, T + w*WINDOW_LEN, QB + w*WINDOW_LEN,
+              QT + w*WINDOW_LEN, method, &scratch, &fit);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = ((t1.tv_sec - t0.tv_sec)*1e9 + (t1.tv_nsec - t0.tv_nsec)) / windows;
+
+    // error of the fitted line against the true one and the anomalies of its
+    // residuals, outside the timing.
+    found = wrong = 0;
+    for (w=0;w<windows;w++)
+    {
+      regress(trace.light + w*WINDOW_LEN, T + w*WINDOW_LEN, QB + w*WINDOW_LEN,
+              QT + w*WINDOW_LEN, method, &scratch, &fit);
+      ssd = 0;
+      for (i=0;i<WINDOW_LEN;i++)
+      {
+        d = (fit.offset + fit.slope*trace.light[w*WINDOW_LEN+i]) -
+            (TRUE_OFFSET + TRUE_SLOPE*trace.light[w*WINDOW_LEN+i]);
+        ssd += d*d;
+      }
+      rms[w] = sqrtf(ssd / WINDOW_LEN);
+
+      getEstimate(trace.light + w*WINDOW_LEN, fit.slope, fit.offset, EstT);
+      n = getAnomalies(T + w*WINDOW_LEN, EstT, ANOMALY_K, &scratch, Index);
+      for (i=0;i<n;i++)
+      {
+        if (spiked[w*WINDOW_LEN+Index[i]])
+          found++;
+        else
+          wrong++;
+      }
+    }
+    qsort(rms, windows, sizeof(float), compareFloats);
+    printf("%-24s %6.0f %13.4f %10.4f %10.1f %13.3f\n", regressName(method), ns,
+           rms[windows/2], rms[(long)(0.95*(windows-1))],
+           spikes ? 100.0*found/spikes : 100.0, (double)wrong/windows);
+  }
+
+  // the tracker, one reading at a time over the whole trace.
+  trackerInit(&tracker);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i=0;i<windows*WINDOW_LEN;i++)
+    trackerUpdate(&tracker, trace.light[i], T[i]);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  ns = ((t1.tv_sec - t0.tv_sec)*1e9 + (t1.tv_nsec - t0.tv_nsec)) / (windows*WINDOW_LEN);
+
+  trackerInit(&tracker);
+  ssd = 0;
+  for (i=0;i<windows*WINDOW_LEN;i++)
+  {
+    trackerUpdate(&tracker, trace.light[i], T[i]);
+    d = tracker.estimate - (TRUE_OFFSET + TRUE_SLOPE*trace.light[i]);
+    if (i >= WINDOW_LEN) // past the first window, as the fits.
+      ssd += d*d;
+  }
+  alarms = tracker.alarms;
+
+  // the same with the offset drifting away from half of the trace on.
+  trackerInit(&tracker);
+  delay = -1;
+  for (i=0;i<windows*WINDOW_LEN && delay < 0;i++)
+  {
+    d = i < windows*WINDOW_LEN/2 ? 0 : drift * (i - windows*WINDOW_LEN/2 + 1);
+    if (trackerUpdate(&tracker, trace.light[i], T[i] + d) != 0 && d != 0)
+      delay = i - windows*WINDOW_LEN/2 + 1;
+  }
+  printf("%-24s %6.0f %13.4f (per reading)\n", "Online Tracker", ns,
+         sqrtf(ssd / (windows*WINDOW_LEN - WINDOW_LEN)));
+  printf("tracker: %ld false drift alarms in %ld readings, drift of %.3f C per reading",
+         alarms, windows*WINDOW_LEN, drift);
+  if (delay < 0)
+    printf(" not detected\n");
+  else
+    printf(" detected after %ld readings (%.2f C)\n", delay, drift*delay);
+
+  free(T);
+  free(QB);
+  free(QT);
+  free(rms);
+  free(spiked);
+  traceClose(&trace);
+  return 0;
+}
@@ -0,0 +1,351 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Offline Replay of Recorded Sensor Traces                                        */
+/*                                                                                 */
+/* Streams a recorded light/temperature trace through the processing pipeline the  */
+/* mote runs (pipelineAddSample/Measure/Regress of sensor-proc.c), as fast as the  */
+/* host allows, and writes one CSV row per report.                                 */
+/*                                                                                 */
+/* The std-dev and aggregation of a report only depend on the last WINDOW_LEN      */
+/* readings and on the position of the reading in the WINDOW_LEN-reading cycle, so */
+/* the trace is cut into contiguous ranges that are processed on all cores in      */
+/* parallel and written out in order; the pipeline of a range is first fed the     */
+/* readings of the cycle before it. The activity classifier carries state from     */
+/* report to report, so it runs once over all the std-devs in trace order between  */
+/* a parallel measuring pass and the parallel aggregation pass, and each range     */
+/* starts from the classifier state it left there.                                 */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -march=native -I. -o replay tools/replay.c tools/kernels.c \          */
+/*       tools/trace.c sensor-proc.c -lpthread                                     */
+/*                                                                                 */
+/* Usage: replay [-j threads] [-k] [-r method] [-o out.csv] trace                  */
+/*   -k runs std-dev, aggregation and the Theil-Sen slopes on the vectorized host  */
+/*   kernels of kernels.h instead of the mote code, with the fixed aggregation     */
+/*   levels only.                                                                  */
+/*   -r picks the regression, ols, wls, theilsen or siegel (default REGRESSION).   */
+/*   trace is either a binary trace (tools/trace-format.h, mmap'd and read in      */
+/*   place) or text whose lines are the mote's own serial output ("Light: x lx,    */
+/*   Temp: y C", with or without a Cooja log prefix) or plain "light,temp" CSV;    */
+/*   other lines are skipped.                                                      */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include "tools/kernels.h"
+#include "tools/trace.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static int use_kernels; // -k
+static int method = REGRESSION; // -r
+
+struct job
+{
+  const struct trace *tr;
+  long first, last; // ticks [first, last) of the trace.
+  float *StdDev;    // of the reports of the range, from measureRange().
+  long reports;
+  struct classifier classifier; // before the first report of the range.
+  char *out;        // CSV rows of the range.
+  size_t len, cap;
+};
+
+/***********************************************************************************/
+/* function to append formatted text to the output of a job */
+static void jobPrintf(struct job *jb, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  for (;;)
+  {
+    va_start(ap, fmt);
+    n = vsnprintf(jb->out + jb->len, jb->cap - jb->len, fmt, ap);
+    va_end(ap);
+    if (n >= 0 && (size_t)n < jb->cap - jb->len)
+      break;
+    jb->cap = jb->cap ? 2*jb->cap : 65536;
+    jb->out = realloc(jb->out, jb->cap);
+    if (jb->out == NULL)
+    {
+      fprintf(stderr, "replay: out of memory\n");
+      exit(1);
+    }
+  }
+  jb->len += n;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get the REGRESS_ method of a -r argument, -1 if unknown */
+static int parseMethod(const char *name)
+{
+  static const char *Names[] = {"ols", "wls", "theilsen", "siegel"};
+  int i;
+
+  for (i=0;i<4;i++)
+  {
+    if (strcmp(name, Names[i]) == 0)
+      return i;
+  }
+  return -1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to fit Theil-Sen with the slopes from the host kernel */
+/* the median of the float slopes, where getTheilSen() ranks fixed point */
+/* fractions; the fits agree to within the rounding to the sensor steps. */
+static void kernelTheilSen(const float B[], const float T[],
+                           float *median_slope, float *median_offset)
+{
+  float slopes[PAIR_COUNT+8], scratch[PAIR_COUNT], offsets[WINDOW_LEN];
+  int slopes_count, i;
+
+  slopes_count = kernelPairSlopes(B, T, WINDOW_LEN, slopes);
+  *median_slope = getMedian(slopes, slopes_count, scratch);
+  for (i=0;i<WINDOW_LEN;i++)
+  {
+    offsets[i] = T[i] - *median_slope * B[i];
+  }
+  *median_offset = getMedian(offsets, WINDOW_LEN, scratch);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up the pipeline of a job as the mote has it before the */
+/* first tick of the range */
+/* fed the readings of the WINDOW_LEN-reading cycle before the one the range */
+/* starts in, so the FIFOs and the window halves hold readings of the trace */
+/* and readcount is in step with the trace. */
+static void pipelineWarmUp(struct sensor_pipeline *p, const struct trace *tr, long first)
+{
+  float X[WINDOW_LEN], light, temp;
+  long s;
+
+  pipelineInit(p);
+  p->fit.method = method;
+  s = first - first%WINDOW_LEN - WINDOW_LEN;
+  for (s=s>0 ? s : 0;s<first;s++)
+  {
+    traceSample(tr, s, &light, &temp);
+    if (pipelineAddSample(p, light, temp) & PIPELINE_MEASURE)
+      pipelineMeasure(p, X);
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to measure the std-dev of the reports of one job */
+static void *measureRange(void *arg)
+{
+  struct job *jb = arg;
+  struct sensor_pipeline p;
+  float X[WINDOW_LEN], light, temp;
+  float Mean, SumofDistSquares;
+  long t;
+
+  jb->StdDev = malloc((jb->last - jb->first + 1) * sizeof(float));
+  if (jb->StdDev == NULL)
+  {
+    fprintf(stderr, "replay: out of memory\n");
+    exit(1);
+  }
+  jb->reports = 0;
+
+  pipelineWarmUp(&p, jb->tr, jb->first);
+  for (t=jb->first;t<jb->last;t++)
+  {
+    traceSample(jb->tr, t, &light, &temp);
+    if (!(pipelineAddSample(&p, light, temp) & PIPELINE_MEASURE))
+      continue;
+    if (use_kernels)
+    {
+      kernelMeanSSD(p.B, WINDOW_LEN, &Mean, &SumofDistSquares);
+      jb->StdDev[jb->reports++] = getSqrt(SumofDistSquares);
+    }
+    else
+    {
+      pipelineMeasure(&p, X);
+      jb->StdDev[jb->reports++] = p.StdDev;
+    }
+  }
+  return NULL;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to replay the ticks of one job */
+/* from the classifier state the classifier pass found for its first report. */
+static void *replayRange(void *arg)
+{
+  struct job *jb = arg;
+  long arena_mem[(REGRESS_MAX_SCRATCH_SIZE + sizeof(long)-1) / sizeof(long)];
+  struct arena scratch;
+  struct sensor_pipeline p;
+  float X[WINDOW_LEN], light, temp;
+  int due, i;
+  long t, r = 0;
+
+  arenaInit(&scratch, arena_mem, sizeof(arena_mem));
+  pipelineWarmUp(&p, jb->tr, jb->first);
+  p.classifier = jb->classifier;
+
+  for (t=jb->first;t<jb->last;t++)
+  {
+    traceSample(jb->tr, t, &light, &temp);
+    due = pipelineAddSample(&p, light, temp);
+    if (!(due & PIPELINE_MEASURE))
+      continue;
+
+    if (use_kernels)
+    {
+      p.StdDev = jb->StdDev[r];
+      p.AggrElementsCount = classifierUpdate(&p.classifier, p.StdDev);
+      kernelBlockMean(p.B, WINDOW_LEN, WINDOW_LEN/p.AggrElementsCount, X);
+    }
+    else
+    {
+      pipelineMeasure(&p, X);
+    }
+
+    jobPrintf(jb, "%ld,%d,%.3f,%d", t, p.readcount, p.StdDev, p.AggrElementsCount);
+    for (i=0;i<WINDOW_LEN;i++)
+    {
+      if (i<p.AggrElementsCount)
+        jobPrintf(jb, ",%.3f", X[i]);
+      else
+        jobPrintf(jb, ",");
+    }
+
+    if (due & PIPELINE_REGRESS)
+    {
+      if (use_kernels && method == REGRESS_THEILSEN)
+        kernelTheilSen(p.B, p.T, &p.fit.slope, &p.fit.offset);
+      else
+        pipelineRegress(&p, &scratch);
+      jobPrintf(jb, ",%.6f,%.6f\n", p.fit.slope, p.fit.offset);
+    }
+    else
+    {
+      jobPrintf(jb, ",,\n");
+    }
+    r++;
+  }
+  return NULL;
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  struct trace tr = {0};
+  struct job *jobs;
+  pthread_t *threads;
+  const char *out_path = NULL;
+  FILE *out = stdout;
+  struct timespec t0, t1;
+  static const float Thresholds[ACTIVITY_LEVELS-1] = {ACTIVITY_LOW, ACTIVITY_HIGH};
+  struct classifier classifier;
+  double elapsed;
+  long per_job, r;
+  int threads_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int opt, i;
+
+  while ((opt = getopt(argc, argv, "j:kr:o:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'j':
+        threads_count = atoi(optarg);
+        break;
+      case 'k':
+        use_kernels = 1;
+        break;
+      case 'r':
+        if ((method = parseMethod(optarg)) < 0)
+        {
+          fprintf(stderr, "replay: unknown regression %s\n", optarg);
+          return 2;
+        }
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-j threads] [-k] [-r method] [-o out.csv] trace\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc-1)
+  {
+    fprintf(stderr, "usage: %s [-j threads] [-k] [-r method] [-o out.csv] trace\n", argv[0]);
+    return 2;
+  }
+  if (threads_count < 1)
+    threads_count = 1;
+
+  if (traceOpen(argv[optind], &tr) != 0)
+    return 1;
+
+  kernelInit();
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  jobs = calloc(threads_count, sizeof(*jobs));
+  threads = calloc(threads_count, sizeof(*threads));
+  per_job = (tr.count + threads_count-1) / threads_count;
+  for (i=0;i<threads_count;i++)
+  {
+    jobs[i].tr = &tr;
+    jobs[i].first = i*per_job < tr.count ? i*per_job : tr.count;
+    jobs[i].last = (i+1)*per_job < tr.count ? (i+1)*per_job : tr.count;
+    pthread_create(&threads[i], NULL, measureRange, &jobs[i]);
+  }
+
+  // the classifier runs over the reports of all ranges in trace order.
+  classifierInit(&classifier, Thresholds, ACTIVITY_HYSTERESIS, ACTIVITY_MIN_DWELL);
+  for (i=0;i<threads_count;i++)
+  {
+    pthread_join(threads[i], NULL);
+    jobs[i].classifier = classifier;
+    for (r=0;r<jobs[i].reports;r++)
+      classifierUpdate(&classifier, jobs[i].StdDev[r]);
+  }
+  for (i=0;i<threads_count;i++)
+    pthread_create(&threads[i], NULL, replayRange, &jobs[i]);
+
+  if (out_path != NULL && (out = fopen(out_path, "w")) == NULL)
+  {
+    perror(out_path);
+    return 1;
+  }
+  fprintf(out, "tick,readcount,stddev,aggregation");
+  for (i=0;i<WINDOW_LEN;i++)
+    fprintf(out, ",x%d", i);
+  fprintf(out, ",slope,offset\n");
+
+  // ranges are written in trace order as their threads finish.
+  for (i=0;i<threads_count;i++)
+  {
+    pthread_join(threads[i], NULL);
+    fwrite(jobs[i].out, 1, jobs[i].len, out);
+    free(jobs[i].out);
+    free(jobs[i].StdDev);
+  }
+  if (out != stdout)
+    fclose(out);
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)/1e9;
+  fprintf(stderr, "replay: %ld samples on %d threads in %.3f s (%.0f samples/s)\n",
+          tr.count, threads_count, elapsed, elapsed > 0 ? tr.count/elapsed : 0);
+
+  free(jobs);
+  free(threads);
+  traceClose(&tr);
+  return 0;
+}
@@ -0,0 +1,40 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Binary Trace Format                                                             */
+/*                                                                                 */
+/* A recorded trace is one header followed by fixed 8-byte records holding the     */
+/* raw ADC readings, so a host tool can mmap the file and index records directly   */
+/* without parsing. All fields are little-endian. The readings are converted to    */
+/* lux and degrees C with lightFromADC()/temperatureFromADC() of sensor-proc.c,    */
+/* the same code the mote uses.                                                    */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef TRACE_FORMAT_H_
+#define TRACE_FORMAT_H_
+
+#include <stdint.h>
+
+#define TRACE_MAGIC "STRC"
+#define TRACE_VERSION 1
+
+struct trace_header
+{
+  char magic[4];          // TRACE_MAGIC, not NUL terminated.
+  uint16_t version;       // TRACE_VERSION.
+  uint16_t record_size;   // sizeof(struct trace_record).
+  uint32_t period_ms;     // nominal sampling period, 500 for 2 readings/sec.
+  uint32_t mote_id;       // 0 when unknown.
+  uint64_t count;         // number of records that follow.
+};
+
+struct trace_record
+{
+  uint32_t time_ms;       // time of the reading since the start of the trace.
+  uint16_t light_adc;     // LIGHT_SENSOR_PHOTOSYNTHETIC reading.
+  uint16_t temp_adc;      // SHT11 temperature reading.
+};
+
+typedef char trace_header_is_24_bytes[sizeof(struct trace_header) == 24 ? 1 : -1];
+typedef char trace_record_is_8_bytes[sizeof(struct trace_record) == 8 ? 1 : -1];
+
+#endif /* TRACE_FORMAT_H_ */
@@ -0,0 +1,210 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Trace Loader, see trace.h                                                       */
+/*                                                                                 */
+/***********************************************************************************/
+#include "tools/trace.h"
+#include "sensor-proc.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LINE_MAX_LEN 1024
+
+/***********************************************************************************/
+/* function to make room for count samples */
+static void traceReserve(struct trace *tr, long count)
+{
+  if (count <= tr->capacity)
+    return;
+  tr->capacity = count;
+  tr->light = realloc(tr->light, tr->capacity*sizeof(float));
+  tr->temp = realloc(tr->temp, tr->capacity*sizeof(float));
+  if (tr->light == NULL || tr->temp == NULL)
+  {
+    fprintf(stderr, "trace: out of memory\n");
+    exit(1);
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to append one sample to the trace */
+static void traceAppend(struct trace *tr, float light, float temp)
+{
+  if (tr->count == tr->capacity)
+    traceReserve(tr, tr->capacity ? 2*tr->capacity : 4096);
+  tr->light[tr->count] = light;
+  tr->temp[tr->count] = temp;
+  tr->count++;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to map a binary trace */
+/* returns 1 when the file is a binary trace, 0 when it is not, -1 on error. */
+static int mapTrace(const char *path, struct trace *tr)
+{
+  const struct trace_header *hdr;
+  struct stat st;
+  void *map;
+  int fd;
+
+  if ((fd = open(path, O_RDONLY)) < 0)
+  {
+    perror(path);
+    return -1;
+  }
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct trace_header))
+  {
+    close(fd);
+    return 0;
+  }
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    perror(path);
+    return -1;
+  }
+
+  hdr = map;
+  if (memcmp(hdr->magic, TRACE_MAGIC, 4) != 0)
+  {
+    munmap(map, st.st_size);
+    return 0;
+  }
+  if (hdr->version != TRACE_VERSION || hdr->record_size != sizeof(struct trace_record) ||
+      hdr->count > (st.st_size - sizeof(*hdr)) / sizeof(struct trace_record))
+  {
+    fprintf(stderr, "%s: unsupported or truncated trace\n", path);
+    munmap(map, st.st_size);
+    return -1;
+  }
+
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+  tr->map = map;
+  tr->map_len = st.st_size;
+  tr->records = (const struct trace_record *)(hdr + 1);
+  tr->count = (long)hdr->count;
+  return 1;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to parse one line of a text trace */
+/* returns 1 when the line held a sample. */
+int traceParseSample(const char *line, float *light, float *temp)
+{
+  const char *p, *q;
+  char *end;
+
+  p = strstr(line, "Light: ");
+  if (p != NULL)
+  {
+    q = strstr(p, "Temp: ");
+    if (q == NULL)
+      return 0;
+    *light = strtof(p+7, &end);
+    if (end == p+7)
+      return 0;
+    *temp = strtof(q+6, &end);
+    return end != q+6;
+  }
+
+  // plain "light,temp" CSV.
+  *light = strtof(line, &end);
+  if (end == line || *end != ',')
+    return 0;
+  p = end+1;
+  *temp = strtof(p, &end);
+  return end != p;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to open a binary or text trace */
+int traceOpen(const char *path, struct trace *tr)
+{
+  char line[LINE_MAX_LEN];
+  float light, temp;
+  FILE *f;
+
+  switch (mapTrace(path, tr))
+  {
+    case 1:
+      return 0;
+    case -1:
+      return -1;
+  }
+
+  f = fopen(path, "r");
+  if (f == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    if (traceParseSample(line, &light, &temp))
+      traceAppend(tr, light, temp);
+  }
+  fclose(f);
+  return 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to load a binary or text trace with all readings converted */
+int traceLoad(const char *path, struct trace *tr)
+{
+  long s;
+
+  if (traceOpen(path, tr) != 0)
+    return -1;
+  if (tr->records == NULL)
+    return 0;
+
+  traceReserve(tr, tr->count);
+  for (s=0;s<tr->count;s++)
+    traceSample(tr, s, &tr->light[s], &tr->temp[s]);
+  munmap(tr->map, tr->map_len);
+  tr->records = NULL;
+  tr->map = NULL;
+  tr->map_len = 0;
+  return 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to get sample s of the trace */
+void traceSample(const struct trace *tr, long s, float *light, float *temp)
+{
+  if (tr->records != NULL)
+  {
+    *light = lightFromADC(tr->records[s].light_adc);
+    *temp = temperatureFromADC(tr->records[s].temp_adc);
+  }
+  else
+  {
+    *light = tr->light[s];
+    *temp = tr->temp[s];
+  }
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to release a trace */
+void traceClose(struct trace *tr)
+{
+  if (tr->map != NULL)
+    munmap(tr->map, tr->map_len);
+  free(tr->light);
+  free(tr->temp);
+  memset(tr, 0, sizeof(*tr));
+}
+/***********************************************************************************/
@@ -0,0 +1,50 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Trace Loader                                                                    */
+/*                                                                                 */
+/* Reads a recorded light/temperature trace for the host tools. A trace is either  */
+/* a binary trace (tools/trace-format.h) or text whose lines are the mote's own    */
+/* serial output ("Light: x lx, Temp: y C", with or without a Cooja log prefix) or */
+/* plain "light,temp" CSV; other lines are skipped.                                */
+/*                                                                                 */
+/* traceOpen() maps a binary trace and reads its records in place, converting each */
+/* with lightFromADC()/temperatureFromADC() of sensor-proc.c as it is asked for;   */
+/* traceLoad() converts all of it into light[] and temp[] up front, for tools that */
+/* index the readings directly. Link tools/trace.c and sensor-proc.c.              */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "tools/trace-format.h"
+#include <stddef.h>
+
+struct trace
+{
+  float *light;  // text traces and traceLoad(), lx.
+  float *temp;   // C.
+  long count;
+  long capacity;
+  const struct trace_record *records; // binary traces of traceOpen(), converted on use.
+  void *map;
+  size_t map_len;
+};
+
+/* parses one line of a text trace, returns 1 when the line held a sample. */
+int traceParseSample(const char *line, float *light, float *temp);
+
+/* opens a trace into tr, which must be zeroed; a binary trace is mapped. */
+/* Returns 0, or -1 after printing why the trace could not be read. */
+int traceOpen(const char *path, struct trace *tr);
+
+/* loads a trace into tr, which must be zeroed, with all readings in light[] */
+/* and temp[]. Returns 0, or -1 after printing why the trace could not be read. */
+int traceLoad(const char *path, struct trace *tr);
+
+/* gets sample s of the trace. */
+void traceSample(const struct trace *tr, long s, float *light, float *temp);
+
+/* releases the readings and the mapping of a trace. */
+void traceClose(struct trace *tr);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,115 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Tracker Check                                                                   */
+/*                                                                                 */
+/* Runs the online tracker of sensor-proc.h over synthetic readings that once made */
+/* it diverge and checks that it holds. The light alternates between 830 and 175   */
+/* ADC counts every 50 readings, the temperature is 22 C plus 0.05 C of noise on   */
+/* the 0.01 C steps of the sensor, 2400 readings per case:                         */
+/*   glitch    +4 C on the first reading                                           */
+/*   glitches  +4 C on every 100th reading                                         */
+/*   step      the glitch, and a real step of +2 C from reading 1200 on            */
+/* Each case must bring the estimate within TOLERANCE of the true temperature by   */
+/* SETTLE readings after the start and after the step, and keep it there, with at  */
+/* most MAX_ALARMS drift alarms; the step must raise one. Reported per case: the   */
+/* alarms, the largest error once settled and the readings the step took to be     */
+/* followed. The exit status is 1 when a case fails.                               */
+/*                                                                                 */
+/* Build (from the top of the repository):                                         */
+/*   gcc -O2 -I. -o trackercheck tools/trackercheck.c sensor-proc.c -lm            */
+/*                                                                                 */
+/* Usage: trackercheck [-s seed]                                                   */
+/*                                                                                 */
+/***********************************************************************************/
+#include "sensor-proc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define READINGS 2400
+#define STEP_AT 1200     // reading of the real offset step.
+#define STEP 2.0f        // C.
+#define GLITCH 4.0f      // C.
+#define SETTLE 100       // readings allowed to settle, at the start and after the step.
+#define TOLERANCE 0.25f  // C.
+#define MAX_ALARMS 3
+
+enum { CASE_GLITCH, CASE_GLITCHES, CASE_STEP, CASES };
+
+static const char *names[CASES] = {"glitch", "glitches", "step"};
+
+/***********************************************************************************/
+/* function to run one case, returns 0 when it holds */
+static int runCase(int c, unsigned int seed)
+{
+  struct tracker t;
+  float light, truth, temp, err, max_err = 0;
+  long followed = -1;
+  unsigned long step_alarms = 0;
+  int i, ok;
+
+  srand(seed);
+  trackerInit(&t);
+  for (i=0;i<READINGS;i++)
+  {
+    light = lightFromADC((i/50) % 2 ? 175 : 830);
+    truth = 22 + (c == CASE_STEP && i >= STEP_AT ? STEP : 0);
+    temp = truth + (rand() % 11 - 5) * 0.01f;
+    if ((c != CASE_GLITCHES && i == 0) || (c == CASE_GLITCHES && i % 100 == 0))
+      temp += GLITCH;
+
+    trackerUpdate(&t, light, temp);
+    if (c == CASE_STEP && i >= STEP_AT)
+      step_alarms += t.drift != 0;
+
+    // the estimate is the prediction before the reading, so a step shows in
+    // it one reading late.
+    err = fabsf(t.estimate - truth);
+    if (c == CASE_STEP && i > STEP_AT && err > TOLERANCE)
+      followed = -1;
+    else if (c == CASE_STEP && i > STEP_AT && followed < 0)
+      followed = i - STEP_AT;
+    if (i >= SETTLE && (i < STEP_AT || i >= STEP_AT + SETTLE || c != CASE_STEP) &&
+        err > max_err)
+      max_err = err;
+  }
+
+  ok = max_err <= TOLERANCE && t.alarms <= MAX_ALARMS &&
+       (c != CASE_STEP || (step_alarms > 0 && followed >= 0 && followed <= SETTLE));
+  printf("%-9s %6lu %12.3f", names[c], t.alarms, max_err);
+  if (c == CASE_STEP)
+    printf(" %14ld", followed);
+  printf("  %s\n", ok ? "ok" : "FAILED");
+  return !ok;
+}
+/***********************************************************************************/
+
+int main(int argc, char *argv[])
+{
+  unsigned int seed = 1;
+  int failed = 0, opt, c;
+
+  while ((opt = getopt(argc, argv, "s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 's':
+        seed = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc)
+  {
+    fprintf(stderr, "usage: %s [-s seed]\n", argv[0]);
+    return 2;
+  }
+
+  printf("case      alarms  max error C  step followed\n");
+  for (c=0;c<CASES;c++)
+    failed |= runCase(c, seed);
+  return failed;
+}
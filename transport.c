@@ -0,0 +1,145 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Report Transport, see transport.h                                               */
+/*                                                                                 */
+/***********************************************************************************/
+#include "transport.h"
+#include <string.h> // for memset(), memcpy().
+
+/***********************************************************************************/
+/* function to set up the sending end */
+/* batch is the number of reports per packet, clamped to 1..TRANSPORT_BATCH. */
+void transportInit(struct transport *t, int batch,
+                   void (*send)(const unsigned char *buf, int len, void *ctx), void *ctx)
+{
+  memset(t, 0, sizeof(*t));
+  if (batch < 1)
+    batch = 1;
+  if (batch > TRANSPORT_BATCH)
+    batch = TRANSPORT_BATCH;
+  t->batch = batch;
+  t->send = send;
+  t->ctx = ctx;
+  t->len = TRANSPORT_HEADER;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to send the reports collected so far, if any */
+void transportFlush(struct transport *t)
+{
+  if (t->count == 0)
+    return;
+
+  t->buf[0] = (unsigned char)(TRANSPORT_VERSION << 4 | t->count);
+  t->buf[1] = t->seq++;
+  t->send(t->buf, t->len, t->ctx);
+
+  t->packets++;
+  t->bytes += t->len;
+  t->len = TRANSPORT_HEADER;
+  t->count = 0;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to queue one encoded report */
+/* the packet goes out when it holds t->batch reports; a report that does not */
+/* fit the payload any more sends the packet first. */
+void transportAddReport(struct transport *t, const unsigned char Enc[], int EncLen)
+{
+  if (t->len + EncLen > TRANSPORT_PAYLOAD)
+    transportFlush(t);
+
+  memcpy(t->buf + t->len, Enc, EncLen);
+  t->len += EncLen;
+  t->count++;
+
+  if (t->count >= t->batch)
+    transportFlush(t);
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to set up the receiving end */
+/* report is called for every decoded report, with fixed point elements. */
+void sinkInit(struct transport_sink *s,
+              void (*report)(unsigned int id, const long X[], int AggrElementsCount,
+                             void *ctx), void *ctx)
+{
+  memset(s, 0, sizeof(*s));
+  s->report = report;
+  s->ctx = ctx;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to find the decoder state of a sender, adding it when new */
+static struct transport_source *getSource(struct transport_sink *s, unsigned int id)
+{
+  struct transport_source *free_src = NULL;
+  int i;
+
+  for (i=0;i<SINK_SOURCES;i++)
+  {
+    if (s->src[i].id == id)
+      return &s->src[i];
+    if (s->src[i].id == 0 && free_src == NULL)
+      free_src = &s->src[i];
+  }
+  if (free_src != NULL)
+  {
+    free_src->id = id;
+    codecInit(&free_src->decoder);
+  }
+  return free_src;
+}
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* function to unpack one packet received from sender id (non-zero) */
+/* returns the number of reports decoded, -1 if the packet is malformed or the */
+/* table of senders is full. */
+int sinkReceive(struct transport_sink *s, unsigned int id,
+                const unsigned char *buf, int len)
+{
+  struct transport_source *src;
+  long X[WINDOW_LEN];
+  int count, n, m, i, AggrElementsCount, decoded = 0;
+
+  if (id == 0 || len < TRANSPORT_HEADER || (buf[0] >> 4) != TRANSPORT_VERSION)
+    return -1;
+  if ((src = getSource(s, id)) == NULL)
+    return -1;
+
+  // a gap in the sequence broke the delta chain, wait for the next key frame.
+  if (src->packets > 0 && buf[1] != src->next_seq)
+  {
+    src->lost += (unsigned char)(buf[1] - src->next_seq);
+    codecInit(&src->decoder);
+  }
+  src->next_seq = buf[1] + 1;
+  src->packets++;
+
+  count = buf[0] & 0x0f;
+  n = TRANSPORT_HEADER;
+  for (i=0;i<count;i++)
+  {
+    m = codecDecode(&src->decoder, buf+n, len-n, X, &AggrElementsCount);
+    if (m < 0)
+    {
+      if ((m = codecReportLength(buf+n, len-n)) < 0)
+        return -1;
+      src->undecodable++;
+    }
+    else
+    {
+      src->reports++;
+      decoded++;
+      s->report(id, X, AggrElementsCount, s->ctx);
+    }
+    n += m;
+  }
+  return decoded;
+}
+/***********************************************************************************/
@@ -0,0 +1,115 @@
+/***********************************************************************************/
+/*                                                                                 */
+/* Report Transport                                                                */
+/*                                                                                 */
+/* Packs encoded reports (report-codec.h) into radio packets for the sink and      */
+/* unpacks them there. A packet carries up to TRANSPORT_BATCH reports so the       */
+/* per-packet cost of the radio (802.15.4 and Rime headers, CCA, ACK) is paid once */
+/* for several reports:                                                            */
+/*                                                                                 */
+/*   byte 0     TRANSPORT_VERSION << 4 | number of reports                         */
+/*   byte 1     packet sequence number, per sender                                 */
+/*   byte 2..   the encoded reports back to back (they are self-delimiting)        */
+/*                                                                                 */
+/* The reports of a mote are delta coded, so the sink drops the decoder state of a */
+/* sender when a sequence number is missing and resumes at its next key frame.     */
+/*                                                                                 */
+/* This part is plain C: the packets go out through a send function given by the   */
+/* caller, Rime unicast on the mote (sensor.c, sink.c) and a direct call into the  */
+/* sink on the host (tools/loopback.c).                                            */
+/*                                                                                 */
+/***********************************************************************************/
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include "report-codec.h"
+
+#define TRANSPORT_VERSION 1
+#define TRANSPORT_HEADER 2 // bytes before the first report.
+
+#ifdef SENSOR_CONF_TRANSPORT_PAYLOAD
+#define TRANSPORT_PAYLOAD SENSOR_CONF_TRANSPORT_PAYLOAD // max bytes per packet.
+#else
+#define TRANSPORT_PAYLOAD 96 // fits the 127-byte 802.15.4 frame with MAC and Rime headers.
+#endif
+
+#ifdef SENSOR_CONF_TRANSPORT_BATCH
+#define TRANSPORT_BATCH SENSOR_CONF_TRANSPORT_BATCH // max reports per packet.
+#else
+#define TRANSPORT_BATCH 4 // one packet every 12 s at one report every 3 s.
+#endif
+
+#ifdef SENSOR_CONF_TRANSPORT_CHANNEL
+#define TRANSPORT_CHANNEL SENSOR_CONF_TRANSPORT_CHANNEL // Rime channel of the reports.
+#else
+#define TRANSPORT_CHANNEL 146
+#endif
+
+#ifdef SENSOR_CONF_SINK_ADDR0
+#define SINK_ADDR0 SENSOR_CONF_SINK_ADDR0 // Rime address of the sink, SINK_ADDR0.SINK_ADDR1.
+#define SINK_ADDR1 SENSOR_CONF_SINK_ADDR1
+#else
+#define SINK_ADDR0 1
+#define SINK_ADDR1 0
+#endif
+
+#ifdef SENSOR_CONF_SINK_SOURCES
+#define SINK_SOURCES SENSOR_CONF_SINK_SOURCES // senders the sink keeps decoders for.
+#else
+#define SINK_SOURCES 16
+#endif
+
+STATIC_ASSERT(TRANSPORT_BATCH >= 1 && TRANSPORT_BATCH <= 15, batch_fits_header);
+STATIC_ASSERT(TRANSPORT_PAYLOAD >= TRANSPORT_HEADER + CODEC_MAX_BYTES, packet_holds_a_report);
+
+/***********************************************************************************/
+/* sending end */
+struct transport
+{
+  unsigned char buf[TRANSPORT_PAYLOAD]; // packet being filled.
+  int len;                              // bytes in buf.
+  int count;                            // reports in buf.
+  int batch;                            // reports per packet, 1 to TRANSPORT_BATCH.
+  unsigned char seq;                    // sequence number of the next packet.
+  void (*send)(const unsigned char *buf, int len, void *ctx);
+  void *ctx;
+
+  unsigned long packets;                // packets sent.
+  unsigned long bytes;                  // payload bytes sent.
+};
+
+void transportInit(struct transport *t, int batch,
+                   void (*send)(const unsigned char *buf, int len, void *ctx), void *ctx);
+void transportAddReport(struct transport *t, const unsigned char Enc[], int EncLen);
+void transportFlush(struct transport *t);
+/***********************************************************************************/
+
+/***********************************************************************************/
+/* receiving end */
+struct transport_source
+{
+  unsigned int id;             // sender address, 0 for a free entry.
+  unsigned char next_seq;      // sequence number expected next.
+  struct report_codec decoder;
+
+  unsigned long packets;       // packets received.
+  unsigned long lost;          // packets missing from the sequence.
+  unsigned long reports;       // reports decoded.
+  unsigned long undecodable;   // reports dropped waiting for a key frame.
+};
+
+struct transport_sink
+{
+  struct transport_source src[SINK_SOURCES];
+  void (*report)(unsigned int id, const long X[], int AggrElementsCount, void *ctx);
+  void *ctx;
+};
+
+void sinkInit(struct transport_sink *s,
+              void (*report)(unsigned int id, const long X[], int AggrElementsCount,
+                             void *ctx), void *ctx);
+int sinkReceive(struct transport_sink *s, unsigned int id,
+                const unsigned char *buf, int len);
+/***********************************************************************************/
+
+#endif /* TRANSPORT_H_ */